@@ -54,6 +54,10 @@ class DeviceHandler {
           // Thử các tên field khác có thể ESP32 gửi
           relay1Status = data.relay1_status || data.relayStatus || data.pumpStatus;
         }
+        if (relay1Status === undefined && typeof data.relays === 'number') {
+          // Bitmask trạng thái relay: bit 0 = relay1 (máy bơm)
+          relay1Status = (data.relays & 1) !== 0;
+        }
         
         // Convert string "true"/"false" thành boolean nếu cần
         if (typeof relay1Status === 'string') {
@@ -10,36 +10,62 @@ const Topics = {
    * Dữ liệu sensor từ thiết bị
    * Format: iot/device/{deviceId}/sensor/data
    * Payload: { temperature, humidity, soilMoisture, isRain, timestamp }
+   * Thiết bị nhiều vùng tưới gửi tất cả vùng trong cùng message (soilMoisture = vùng 0):
+   *   zones: [{ zone, soilMoisture, pump, mode }, ...]
    */
   SENSOR_DATA: (deviceId) => `iot/device/${deviceId}/sensor/data`,
   
   /**
    * Trạng thái thiết bị (online/offline)
    * Format: iot/device/{deviceId}/status
-   * Payload: { status: "online" | "offline", timestamp }
+   * Payload: { status: "online" | "offline", mode, zoneCount, timestamp }
    */
   DEVICE_STATUS: (deviceId) => `iot/device/${deviceId}/status`,
   
   /**
    * Heartbeat từ thiết bị
    * Format: iot/device/{deviceId}/heartbeat
-   * Payload: { timestamp }
+   * Payload: { relay1Status, relays, timestamp }
+   * relays: bitmask trạng thái relay (bit i = kênh i đang bật)
    */
   DEVICE_HEARTBEAT: (deviceId) => `iot/device/${deviceId}/heartbeat`,
   
+  /**
+   * Sự kiện mưa/tạnh (gửi ngay khi cảm biến đổi trạng thái)
+   * Format: iot/device/{deviceId}/event
+   * Payload: { event: "rain_start" | "rain_stop", previousStateMs, irqToRelayUs, rainMsTotal, dryMsTotal, timestamp }
+   */
+  DEVICE_EVENT: (deviceId) => `iot/device/${deviceId}/event`,
+  
+  /**
+   * Số liệu chẩn đoán của thiết bị
+   * Format: iot/device/{deviceId}/diagnostics
+   * Payload: { rainEvents, irqToRelayLastUs, irqToRelayMaxUs, irqToRelayAvgUs, rainMsTotal, dryMsTotal, timestamp }
+   */
+  DEVICE_DIAGNOSTICS: (deviceId) => `iot/device/${deviceId}/diagnostics`,
+  
   // ===== Backend → ESP32 (Subscribe) =====
   
   /**
    * Lệnh điều khiển thiết bị
    * Format: iot/device/{deviceId}/command
-   * Payload: { action: "pump_on" | "pump_off" | "light_on" | "light_off", ... }
+   * Payload: { action: "pump_on" | "pump_off" | "relay2_on" | "relay2_off", duration?: ms }
+   *      hoặc: { actions: [{ channel: "pump" | 0, state: "on" | "off", duration?: ms }, ...] }
+   * Theo vùng tưới: { zone: 1, action: "pump_on" | "pump_off" }
+   *      hoặc phần tử batch { zone: 1, state: "on", duration?: ms } thay cho channel
+   * duration: thiết bị tự tắt kênh sau khoảng thời gian này
+   * Vùng nằm trong payload: một topic command/config cho mọi vùng của thiết bị
    */
   DEVICE_COMMAND: (deviceId) => `iot/device/${deviceId}/command`,
   
   /**
    * Cấu hình thiết bị
    * Format: iot/device/{deviceId}/config
-   * Payload: { threshold: {...}, schedule: {...}, ... }
+   * Payload: { mode, threshold: { soilDry, soilWet, hotTemp, dryHumidity },
+   *            intervals: { loop, sensorPublish, heartbeat }, schedule: [...] }
+   * mode/threshold áp dụng cho mọi vùng; thêm zone: n để chỉ áp dụng cho vùng n,
+   * hoặc zones: [{ zone, mode?, threshold? }, ...] cho nhiều vùng một lần
+   * Thiết bị lưu config vào NVS, nên không cần gửi lại sau mỗi lần reboot
    */
   DEVICE_CONFIG: (deviceId) => `iot/device/${deviceId}/config`,
 
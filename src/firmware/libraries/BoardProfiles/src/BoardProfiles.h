@@ -0,0 +1,129 @@
+/**
+ * Board Profiles
+ * Cấu hình phần cứng theo từng loại board, xác định hoàn toàn lúc biên dịch:
+ * chân GPIO, bộ cảm biến có lắp, hiệu chỉnh. Mỗi profile là một namespace
+ * chứa hằng constexpr; sketch chọn profile qua macro BOARD_PROFILE
+ * (mặc định irrigation_v1), ví dụ: -DBOARD_PROFILE=voice_v1
+ *
+ * Cảm biến không lắp (HAS_xxx = false) thì driver tương ứng bị loại khỏi
+ * binary (xem ClimateSensor<> trong main/Sensors.h và các nhánh if theo hằng số).
+ */
+
+#ifndef BOARD_PROFILES_H
+#define BOARD_PROFILES_H
+
+#include <stddef.h>
+
+namespace board {
+
+const int PIN_NONE = -1;
+
+// Board tưới cây chính (main/): đất + mưa + DHT11 + mic, 2 relay
+namespace irrigation_v1 {
+  constexpr const char* NAME = "irrigation_v1";
+
+  // Dùng các chân ADC1 (32, 33, 34, 35, 36, 39) để tránh xung đột WiFi
+  constexpr int PIN_SOIL = 34;      // Cảm biến Đất (Analog)
+  constexpr int PIN_RAIN = 32;      // Cảm biến Mưa (Digital, LOW = có nước)
+  constexpr int PIN_DHT = 33;       // Cảm biến Nhiệt/Ẩm
+  constexpr int PIN_MIC = 35;       // Cảm biến Âm thanh (Analog)
+  constexpr int PIN_RELAY_1 = 13;   // Máy bơm
+  constexpr int PIN_RELAY_2 = 12;
+
+  constexpr bool HAS_SOIL = true;
+  constexpr bool HAS_RAIN = true;
+  constexpr bool HAS_DHT = true;
+  constexpr bool HAS_MIC = true;
+
+  constexpr int DHT_TYPE = 11;      // DHT11
+
+  // Vùng tưới: mỗi vùng một cảm biến đất + một relay bơm/van (vùng 0 = PIN_SOIL/PIN_RELAY_1)
+  constexpr int ZONE_COUNT = 1;
+  constexpr int ZONE_SOIL_PINS[] = { PIN_SOIL };
+  constexpr int ZONE_RELAY_PINS[] = { PIN_RELAY_1 };
+
+  // Cảm biến Đất FC-28
+  constexpr int SOIL_AIR_VALUE = 4095;    // Giá trị khi khô
+  constexpr int SOIL_WATER_VALUE = 1800;  // Giá trị khi ướt
+  // Cảm biến Âm thanh (MAX4466/9814)
+  constexpr int MIC_NOISE_THRESHOLD = 500;
+}
+
+// Board tưới nhiều vùng: như irrigation_v1 nhưng 3 cảm biến đất + 3 relay vùng
+namespace irrigation_zones_v1 {
+  constexpr const char* NAME = "irrigation_zones_v1";
+
+  constexpr int PIN_SOIL = 34;
+  constexpr int PIN_RAIN = 32;
+  constexpr int PIN_DHT = 33;
+  constexpr int PIN_MIC = 35;
+  constexpr int PIN_RELAY_1 = 13;   // Bơm vùng 0
+  constexpr int PIN_RELAY_2 = 12;
+
+  constexpr bool HAS_SOIL = true;
+  constexpr bool HAS_RAIN = true;
+  constexpr bool HAS_DHT = true;
+  constexpr bool HAS_MIC = true;
+
+  constexpr int DHT_TYPE = 11;
+
+  // Đất dùng các chân ADC1 còn trống (36 = VP, 39 = VN)
+  constexpr int ZONE_COUNT = 3;
+  constexpr int ZONE_SOIL_PINS[] = { PIN_SOIL, 36, 39 };
+  constexpr int ZONE_RELAY_PINS[] = { PIN_RELAY_1, 14, 27 };
+
+  constexpr int SOIL_AIR_VALUE = 4095;
+  constexpr int SOIL_WATER_VALUE = 1800;
+  constexpr int MIC_NOISE_THRESHOLD = 500;
+}
+
+// Board thu âm (voice_control/): chỉ mic + 1 relay
+namespace voice_v1 {
+  constexpr const char* NAME = "voice_v1";
+
+  constexpr int PIN_SOIL = PIN_NONE;
+  constexpr int PIN_RAIN = PIN_NONE;
+  constexpr int PIN_DHT = PIN_NONE;
+  constexpr int PIN_MIC = 35;       // MAX4466 OUT -> GPIO 35 (ADC1)
+  constexpr int PIN_RELAY_1 = 25;
+  constexpr int PIN_RELAY_2 = PIN_NONE;
+
+  constexpr bool HAS_SOIL = false;
+  constexpr bool HAS_RAIN = false;
+  constexpr bool HAS_DHT = false;
+  constexpr bool HAS_MIC = true;
+
+  constexpr int DHT_TYPE = 11;
+
+  constexpr int ZONE_COUNT = 0;     // Không tưới
+  constexpr int ZONE_SOIL_PINS[] = { PIN_NONE };
+  constexpr int ZONE_RELAY_PINS[] = { PIN_NONE };
+
+  constexpr int SOIL_AIR_VALUE = 4095;
+  constexpr int SOIL_WATER_VALUE = 1800;
+  constexpr int MIC_NOISE_THRESHOLD = 500;
+}
+
+}  // namespace board
+
+#ifndef BOARD_PROFILE
+#define BOARD_PROFILE irrigation_v1
+#endif
+
+namespace Board = board::BOARD_PROFILE;
+
+// Kiểm tra profile lúc biên dịch
+static_assert(!Board::HAS_SOIL || Board::PIN_SOIL >= 0, "HAS_SOIL requires PIN_SOIL");
+static_assert(!Board::HAS_RAIN || Board::PIN_RAIN >= 0, "HAS_RAIN requires PIN_RAIN");
+static_assert(!Board::HAS_DHT || Board::PIN_DHT >= 0, "HAS_DHT requires PIN_DHT");
+static_assert(!Board::HAS_MIC || Board::PIN_MIC >= 0, "HAS_MIC requires PIN_MIC");
+static_assert(Board::SOIL_AIR_VALUE != Board::SOIL_WATER_VALUE, "Soil calibration range is empty");
+static_assert(sizeof(Board::ZONE_SOIL_PINS) / sizeof(int) >= (size_t)Board::ZONE_COUNT &&
+              sizeof(Board::ZONE_RELAY_PINS) / sizeof(int) >= (size_t)Board::ZONE_COUNT,
+              "Zone pin tables shorter than ZONE_COUNT");
+static_assert(Board::ZONE_COUNT == 0 || (Board::ZONE_SOIL_PINS[0] == Board::PIN_SOIL &&
+                                         Board::ZONE_RELAY_PINS[0] == Board::PIN_RELAY_1),
+              "Zone 0 must use PIN_SOIL / PIN_RELAY_1");
+static_assert(Board::ZONE_COUNT == 0 || Board::HAS_SOIL, "Zones require soil sensors");
+
+#endif
@@ -0,0 +1,191 @@
+/**
+ * Actuator Module
+ * Quản lý các kênh relay: ACTUATORS[] và relay các vùng (actuatorDef(), Config.h)
+ * Hỗ trợ bật/tắt theo xung (duration) - tự tắt trên thiết bị khi hết giờ.
+ * Hết giờ xung do esp_timer xử lý (task riêng), nên kênh vẫn tự tắt khi loop()
+ * đang bị chặn (mất WiFi/broker, OTA) - đúng lúc giới hạn này cần nhất.
+ */
+
+#ifndef ACTUATORS_H
+#define ACTUATORS_H
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "Config.h"
+
+// Trạng thái runtime của từng kênh
+struct ActuatorState {
+  bool on;
+  unsigned long pulseDuration; // 0 = không hẹn giờ tắt
+  int64_t pulseDeadlineUs;     // esp_timer_get_time() lúc hết xung
+};
+
+ActuatorState actuatorStates[ACTUATOR_COUNT];
+esp_timer_handle_t actuatorTimers[ACTUATOR_COUNT];   // Timer một lần cho xung của từng kênh
+volatile unsigned long actuatorPulseEnded = 0;        // bit i = kênh i vừa tự tắt, chờ loop() báo
+portMUX_TYPE actuatorMux = portMUX_INITIALIZER_UNLOCKED;  // Trạng thái dùng chung với task esp_timer
+
+// Một thao tác trong lệnh (đơn lẻ hoặc batch)
+struct ActuatorAction {
+  int channel;
+  bool on;
+  unsigned long duration; // ms, 0 = giữ nguyên đến khi có lệnh khác
+};
+
+/**
+ * Ghi mức ra chân relay theo activeLow
+ */
+void writeActuatorPin(int channel, bool on) {
+  const ActuatorDef& def = actuatorDef(channel);
+  if (def.pin < 0) {
+    return;  // Board không lắp relay này
+  }
+  bool level = def.activeLow ? !on : on;
+  digitalWrite(def.pin, level ? HIGH : LOW);
+}
+
+/**
+ * Hết giờ xung (chạy trong task esp_timer): tắt kênh, đánh dấu để loop() log/publish.
+ * Bỏ qua nếu kênh đã bị tắt hoặc nhận xung mới trong lúc timer chờ chạy.
+ */
+void onActuatorPulseEnd(void* arg) {
+  int channel = (int)(intptr_t)arg;
+  portENTER_CRITICAL(&actuatorMux);
+  ActuatorState& st = actuatorStates[channel];
+  if (st.on && st.pulseDuration > 0 && esp_timer_get_time() >= st.pulseDeadlineUs) {
+    st.on = false;
+    st.pulseDuration = 0;
+    writeActuatorPin(channel, false);
+    actuatorPulseEnded |= (1UL << channel);
+  }
+  portEXIT_CRITICAL(&actuatorMux);
+}
+
+/**
+ * Khởi tạo tất cả relay ở trạng thái TẮT
+ */
+void initActuators() {
+  for (int i = 0; i < ACTUATOR_COUNT; i++) {
+    if (actuatorDef(i).pin >= 0) {
+      pinMode(actuatorDef(i).pin, OUTPUT);
+    }
+    writeActuatorPin(i, false);
+    actuatorStates[i].on = false;
+    actuatorStates[i].pulseDuration = 0;
+    actuatorStates[i].pulseDeadlineUs = 0;
+    if (actuatorTimers[i] == NULL) {
+      esp_timer_create_args_t args = {};
+      args.callback = onActuatorPulseEnd;
+      args.arg = (void*)(intptr_t)i;
+      args.dispatch_method = ESP_TIMER_TASK;
+      args.name = "pulse";
+      if (esp_timer_create(&args, &actuatorTimers[i]) != ESP_OK) {
+        actuatorTimers[i] = NULL;  // updateActuators() kiểm tra hết giờ thay timer
+        Serial.println("⚠️  Pulse timer unavailable, pulses end from loop()");
+      }
+    }
+  }
+  actuatorPulseEnded = 0;
+}
+
+/**
+ * Kênh có tồn tại trên board này không (pin khác PIN_NONE)
+ */
+bool isActuatorAvailable(int channel) {
+  return channel >= 0 && channel < ACTUATOR_COUNT && actuatorDef(channel).pin >= 0;
+}
+
+/**
+ * Tìm kênh theo tên
+ * @return chỉ số kênh, -1 nếu không tồn tại
+ */
+int findActuator(const String& name) {
+  for (int i = 0; i < ACTUATOR_COUNT; i++) {
+    if (isActuatorAvailable(i) && name == actuatorDef(i).name) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/**
+ * Bật/tắt một kênh
+ * @param channel Chỉ số kênh
+ * @param on true = bật
+ * @param duration Thời gian bật (ms), hết giờ sẽ tự tắt. 0 = không hẹn giờ
+ */
+void setActuator(int channel, bool on, unsigned long duration = 0) {
+  if (channel < 0 || channel >= ACTUATOR_COUNT) {
+    return;
+  }
+  if (actuatorTimers[channel] != NULL) {
+    esp_timer_stop(actuatorTimers[channel]);  // Lỗi khi timer không chạy: bỏ qua
+  }
+  ActuatorState& st = actuatorStates[channel];
+  portENTER_CRITICAL(&actuatorMux);
+  st.on = on;
+  st.pulseDuration = on ? duration : 0;
+  st.pulseDeadlineUs = esp_timer_get_time() + (int64_t)st.pulseDuration * 1000;
+  writeActuatorPin(channel, on);
+  actuatorPulseEnded &= ~(1UL << channel);
+  portEXIT_CRITICAL(&actuatorMux);
+  if (st.pulseDuration > 0 && actuatorTimers[channel] != NULL) {
+    esp_timer_start_once(actuatorTimers[channel], (uint64_t)st.pulseDuration * 1000);
+  }
+}
+
+bool isActuatorOn(int channel) {
+  if (channel < 0 || channel >= ACTUATOR_COUNT) {
+    return false;
+  }
+  return actuatorStates[channel].on;
+}
+
+/**
+ * Bitmask trạng thái tất cả kênh (bit i = kênh i đang bật)
+ */
+unsigned long actuatorStateMask() {
+  unsigned long mask = 0;
+  for (int i = 0; i < ACTUATOR_COUNT; i++) {
+    if (actuatorStates[i].on) {
+      mask |= (1UL << i);
+    }
+  }
+  return mask;
+}
+
+/**
+ * Áp dụng một danh sách thao tác. Các thao tác đã được kiểm tra hợp lệ
+ * trước khi gọi, nên toàn bộ được ghi ra relay trong cùng một lượt.
+ */
+void applyActuatorActions(const ActuatorAction* actions, int count) {
+  for (int i = 0; i < count; i++) {
+    setActuator(actions[i].channel, actions[i].on, actions[i].duration);
+  }
+}
+
+/**
+ * Báo các kênh timer vừa tự tắt, gọi trong loop()
+ * @return true nếu có kênh vừa tự tắt (cần publish trạng thái)
+ */
+bool updateActuators() {
+  for (int i = 0; i < ACTUATOR_COUNT; i++) {
+    if (actuatorTimers[i] == NULL) {
+      onActuatorPulseEnd((void*)(intptr_t)i);  // Không có timer: kiểm tra hết giờ tại đây
+    }
+  }
+  portENTER_CRITICAL(&actuatorMux);
+  unsigned long ended = actuatorPulseEnded;
+  actuatorPulseEnded = 0;
+  portEXIT_CRITICAL(&actuatorMux);
+
+  for (int i = 0; i < ACTUATOR_COUNT; i++) {
+    if (ended & (1UL << i)) {
+      Serial.print("⏱️  Pulse ended, channel OFF: ");
+      Serial.println(actuatorDef(i).name);
+    }
+  }
+  return ended != 0;
+}
+
+#endif
@@ -1,43 +1,106 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
-// --- 1. CẤU HÌNH CHÂN (PIN MAPPING) ---
-// Lưu ý: Dùng các chân ADC1 (32, 33, 34, 35, 36, 39) để tránh xung đột WiFi sau này
-const int PIN_SOIL = 34;      // Cảm biến Đất (Analog) -> GPIO 34
-const int PIN_RAIN = 32;      // Cảm biến Mưa (Digital) -> GPIO 32
-const int PIN_DHT  = 33;      // Cảm biến Nhiệt/Ẩm (DHT11) -> GPIO 33
-const int PIN_MIC  = 35;      // Cảm biến Âm thanh (Analog) -> GPIO 35
-const int PIN_RELAY_1 = 13;
-const int PIN_RELAY_2 = 12;
-
-// --- 4. CẤU HÌNH WIFI ---
-const char* ssid = "iPhone (84)";
-const char* password = "12345678";
-
-// --- 5. CẤU HÌNH MQTT ---
-// Tạm thời dùng broker công cộng (không cần cài Mosquitto)
-const char* mqtt_broker = "broker.hivemq.com";  // Broker công cộng
-const int mqtt_port = 1883;
-const char* deviceId = "ESP32_001";  // ID thiết bị (thay đổi cho mỗi ESP32)
-// --- 2. CẤU HÌNH CẢM BIẾN ---
-#define DHTTYPE DHT11
-
-// --- 3. CẤU HÌNH HIỆU CHỈNH (CALIBRATION) ---
-// Cảm biến Đất FC-28 (Bạn thay số thực tế vào đây)
-const int SOIL_AIR_VALUE   = 4095; // Giá trị khi khô
-const int SOIL_WATER_VALUE = 1800; // Giá trị khi ướt
-
-// Cảm biến Âm thanh (MAX4466/9814)
-const int MIC_NOISE_THRESHOLD = 500; // Ngưỡng phát hiện tiếng ồn
-
-// --- 6. CẤU HÌNH CHẾ ĐỘ HOẠT ĐỘNG ---
-// Mode mặc định: "auto" (tự động), "manual" (thủ công), "schedule" (lịch trình)
-// Mode sẽ được cập nhật từ Backend qua MQTT config
-String deviceMode = "auto"; // Mặc định là tự động
+// --- 1. CẤU HÌNH PHẦN CỨNG (BOARD PROFILE) ---
+// Chân GPIO, bộ cảm biến có lắp và hiệu chỉnh nằm trong thư viện BoardProfiles
+// (src/firmware/libraries), chọn lúc biên dịch: Board::PIN_SOIL, Board::HAS_DHT...
+// Board khác: thêm -DBOARD_PROFILE=<tên profile> vào build flags.
+#include <BoardProfiles.h>
+
+// --- 2. WIFI / MQTT / DEVICE ID ---
+// Không còn hard-code trong source: được nạp vào NVS (xem Provisioning.h).
+// Chỉ giữ giá trị mặc định cho những gì không bí mật.
+const char* DEFAULT_MQTT_BROKER = "broker.hivemq.com";  // Broker công cộng
+const uint16_t DEFAULT_MQTT_PORT = 1883;
+
+// Seed lần boot đầu: chỉ dùng khi namespace "prov" trong NVS còn trống (thiết bị nâng cấp
+// OTA từ firmware hard-code WiFi/deviceId, hoặc sau {"reset":true}). Mặc định là giá trị
+// cũ để thiết bị vẫn vào mạng và giữ deviceId khớp record trên Backend.
+// Thiết bị mới: -DPROVISION_SSID=\"\" để tắt seed và chờ provisioning qua Serial.
+#ifndef PROVISION_SSID
+#define PROVISION_SSID "iPhone (84)"
+#endif
+#ifndef PROVISION_PASSWORD
+#define PROVISION_PASSWORD "12345678"
+#endif
+#ifndef PROVISION_DEVICE_ID
+#define PROVISION_DEVICE_ID "ESP32_001"
+#endif
+
+// Kết nối lại không chặn loop(): mỗi lần gọi thử tối đa một lần, cách nhau ít nhất
+const unsigned long MQTT_RETRY_INTERVAL = 5000;
+const unsigned long WIFI_RETRY_INTERVAL = 30000;  // Gọi lại WiFi.begin() nếu vẫn mất WiFi
+const uint16_t MQTT_SOCKET_TIMEOUT_S = 5;         // Chờ CONNACK tối đa (mặc định PubSubClient 15s)
+
+// --- 3. CẤU HÌNH CẢM BIẾN ---
+// Cảm biến Mưa: chống dội (debounce) cho ngắt GPIO
+const unsigned long RAIN_DEBOUNCE_MS = 50;
+
+// --- 4. CẤU HÌNH CHẾ ĐỘ HOẠT ĐỘNG ---
+// Mode và các chu kỳ bên dưới chỉ là giá trị MẶC ĐỊNH khi NVS chưa có config.
+// Config thực tế nằm trong deviceConfig (DeviceConfig.h), cập nhật từ Backend qua MQTT config
 
 const unsigned long LOOP_INTERVAL = 5000;  // Logic điều khiển mỗi 5 giây
 const unsigned long HEARTBEAT_INTERVAL = 30000; 
 const unsigned long SENSOR_PUBLISH_INTERVAL = 30000;
 
+// --- 5. VÙNG TƯỚI (ZONE) ---
+// Mỗi vùng có cảm biến đất, relay bơm/van, mode và ngưỡng riêng (DeviceConfig.zones).
+// Số vùng và chân lấy từ board profile; vùng 0 là bơm chính (kênh "pump").
+const int MAX_ZONES = 4;
+const int ZONE_COUNT = Board::ZONE_COUNT;
+static_assert(ZONE_COUNT <= MAX_ZONES, "Board has more zones than MAX_ZONES");
+
+constexpr int zoneSoilPin(int zone) {
+  return zone < Board::ZONE_COUNT ? Board::ZONE_SOIL_PINS[zone] : board::PIN_NONE;
+}
+
+constexpr int zoneRelayPin(int zone) {
+  return zone < Board::ZONE_COUNT ? Board::ZONE_RELAY_PINS[zone] : board::PIN_NONE;
+}
+
+// --- 6. CẤU HÌNH ACTUATOR (RELAY) ---
+// Mỗi kênh có tên (dùng trong lệnh MQTT), chân GPIO và mức kích hoạt.
+// Thêm relay mới chỉ cần thêm một dòng vào bảng ACTUATORS[].
+struct ActuatorDef {
+  const char* name;   // Tên kênh: "pump" -> lệnh "pump_on" / "pump_off"
+  int pin;            // Chân GPIO
+  bool activeLow;     // true = relay kích mức LOW (module relay thông dụng)
+};
+
+// Kênh cố định; giữ nguyên chỉ số 0/1 (bit trong "relays" của heartbeat).
+// Kênh có pin PIN_NONE (board không lắp) bị bỏ qua.
+constexpr ActuatorDef ACTUATORS[] = {
+  { "pump",   Board::PIN_RELAY_1, true },   // Kênh 0: Máy bơm vùng 0 (relay 1)
+  { "relay2", Board::PIN_RELAY_2, true },   // Kênh 1: Relay 2 (PIN_NONE nếu board không có)
+};
+const int ACTUATOR_PUMP = 0;         // Chỉ số kênh máy bơm trong ACTUATORS[]
+
+// Relay vùng 1..ZONE_COUNT-1 (Board::ZONE_RELAY_PINS) nối tiếp sau các kênh cố định,
+// số kênh theo board: board một vùng không có kênh vùng nào.
+const int ACTUATOR_ZONE_BASE = sizeof(ACTUATORS) / sizeof(ACTUATORS[0]);
+const int ACTUATOR_COUNT = ACTUATOR_ZONE_BASE + (ZONE_COUNT > 1 ? ZONE_COUNT - 1 : 0);
+static_assert(ACTUATOR_COUNT <= 32, "Actuator bitmasks are 32-bit");
+
+// Tên kênh relay của vùng (lệnh "pump1_on", ...); vùng 0 là kênh "pump"
+constexpr const char* ZONE_PUMP_NAMES[] = { "pump", "pump1", "pump2", "pump3" };
+static_assert(sizeof(ZONE_PUMP_NAMES) / sizeof(ZONE_PUMP_NAMES[0]) == MAX_ZONES,
+              "One pump name per zone");
+
+// Kênh relay của vùng trong danh sách kênh
+constexpr int zoneActuator(int zone) {
+  return zone == 0 ? ACTUATOR_PUMP : ACTUATOR_ZONE_BASE + zone - 1;
+}
+
+// Mô tả kênh: kênh cố định lấy từ ACTUATORS[], kênh vùng sinh từ bảng chân của board
+constexpr ActuatorDef actuatorDef(int channel) {
+  return channel < ACTUATOR_ZONE_BASE
+      ? ACTUATORS[channel]
+      : ActuatorDef{ ZONE_PUMP_NAMES[channel - ACTUATOR_ZONE_BASE + 1],
+                     zoneRelayPin(channel - ACTUATOR_ZONE_BASE + 1), true };
+}
+
+const unsigned long ACTUATOR_MAX_PULSE_MS = 3600000UL; // Giới hạn xung tối đa 1 giờ
+
 
 #endif
\ No newline at end of file
@@ -1,51 +1,92 @@
 /**
  * Control Logic Module
- * Logic điều khiển bơm dựa trên dữ liệu sensor
- * CHỈ CHẠY KHI MODE = "auto"
+ * Logic điều khiển bơm dựa trên dữ liệu sensor, chạy riêng cho từng vùng tưới
+ * CHỈ CHẠY KHI MODE (của vùng) = auto
  */
 
 #ifndef CONTROL_H
 #define CONTROL_H
 
 #include "Config.h"
+#include "Actuators.h"
+#include "DeviceConfig.h"
 
 /**
- * Điều khiển bơm dựa trên logic nghiệp vụ
- * CHỈ CHẠY KHI deviceMode == "auto"
- * @param soilMoisture Độ ẩm đất (%)
+ * In log thao tác bơm: "💧 [AUTO] pump1 ON: <lý do>"
+ */
+void logZoneAction(const char* tag, int channel, bool on, const char* reason) {
+  Serial.print("💧 [");
+  Serial.print(tag);
+  Serial.print("] ");
+  Serial.print(actuatorDef(channel).name);
+  Serial.print(on ? " ON: " : " OFF: ");
+  Serial.println(reason);
+}
+
+/**
+ * Điều khiển bơm của một vùng dựa trên logic nghiệp vụ
+ * CHỈ CHẠY KHI mode của vùng == MODE_AUTO (MODE_OFF: luôn tắt bơm)
+ * @param zone Chỉ số vùng (0..ZONE_COUNT-1)
+ * @param soilMoisture Độ ẩm đất của vùng (%)
  * @param temperature Nhiệt độ (°C)
  * @param humidity Độ ẩm không khí (%)
+ * @param climateValid false khi chưa đọc được DHT: bỏ qua nhánh nóng/khô
  * @param isRain Có mưa hay không
- * @param currentMode Chế độ hiện tại của thiết bị ("auto", "manual", "schedule")
+ * @param cfg Cấu hình hiện tại (mode + ngưỡng từng vùng)
  */
-void controlPump(int soilMoisture, int temperature, int humidity, bool isRain, String currentMode) {
-  // CHỈ chạy logic tự động khi mode = "auto"
-  if (currentMode != "auto") {
+void controlZone(int zone, int soilMoisture, int temperature, int humidity, bool climateValid, bool isRain,
+                 const DeviceConfig& cfg) {
+  const ZoneConfig& zc = cfg.zones[zone];
+  const int pump = zoneActuator(zone);
+  
+  if (zc.mode == MODE_OFF) {
+    if (isActuatorOn(pump)) {
+      setActuator(pump, false);
+      logZoneAction("OFF", pump, false, "zone mode is off");
+    }
+    return;
+  }
+  
+  // CHỈ chạy logic tự động khi mode = auto
+  if (zc.mode != MODE_AUTO) {
     // Ở chế độ manual hoặc schedule, không chạy logic tự động
     // Bơm chỉ được điều khiển qua MQTT command từ Backend
     return;
   }
   
+  const ControlThresholds& t = zc.threshold;
+  
   // Logic tự động chỉ chạy khi mode = "auto"
-  if(soilMoisture < 40 && isRain == false){
+  if(soilMoisture < t.soilDry && isRain == false){
     // Đất khô và không mưa → Bật bơm
-    digitalWrite(PIN_RELAY_1, LOW);
-    Serial.println("💧 [AUTO] Pump ON: Soil dry, no rain");
+    setActuator(pump, true);
+    logZoneAction("AUTO", pump, true, "Soil dry, no rain");
   }
-  else if (soilMoisture < 40 && isRain == true){
+  else if (soilMoisture < t.soilDry && isRain == true){
     // Đất khô nhưng có mưa → Tắt bơm (đợi mưa)
-    digitalWrite(PIN_RELAY_1, HIGH); 
-    Serial.println("💧 [AUTO] Pump OFF: Rain detected");
+    setActuator(pump, false); 
+    logZoneAction("AUTO", pump, false, "Rain detected");
   }
-  else if (soilMoisture >= 80){ 
+  else if (soilMoisture >= t.soilWet){ 
     // Đất đủ ẩm → Tắt bơm
-    digitalWrite(PIN_RELAY_1, HIGH); 
-    Serial.println("💧 [AUTO] Pump OFF: Soil moist enough");
+    setActuator(pump, false); 
+    logZoneAction("AUTO", pump, false, "Soil moist enough");
   }
-  else if ((soilMoisture <= 60 || soilMoisture >= 40) && temperature >= 35 && humidity <= 40){
+  else if (climateValid && (soilMoisture <= 60 || soilMoisture >= 40) && temperature >= t.hotTemp && humidity <= t.dryHumidity){
     // Đất vừa phải, nóng và khô → Bật bơm
-    digitalWrite(PIN_RELAY_1, LOW);
-    Serial.println("💧 [AUTO] Pump ON: Hot and dry conditions");
+    setActuator(pump, true);
+    logZoneAction("AUTO", pump, true, "Hot and dry conditions");
+  }
+}
+
+/**
+ * Chạy logic điều khiển cho tất cả vùng (nhiệt độ/ẩm/mưa dùng chung cả board)
+ * @param soilMoisture Độ ẩm đất từng vùng (%), ZONE_COUNT phần tử
+ */
+void controlZones(const int* soilMoisture, int temperature, int humidity, bool climateValid, bool isRain,
+                  const DeviceConfig& cfg) {
+  for (int z = 0; z < ZONE_COUNT; z++) {
+    controlZone(z, soilMoisture[z], temperature, humidity, climateValid, isRain, cfg);
   }
 }
 
@@ -0,0 +1,267 @@
+/**
+ * Device Config Module
+ * Lưu cấu hình thiết bị (mode/ngưỡng từng vùng, chu kỳ, lịch) vào NVS dạng blob nhị phân
+ * có version + CRC32, nạp lại ngay trong setup() để thiết bị chạy đúng logic
+ * ngay sau reboot/OTA mà không cần đợi Backend gửi lại config.
+ */
+
+#ifndef DEVICE_CONFIG_H
+#define DEVICE_CONFIG_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "Config.h"
+
+// --- Chế độ hoạt động (khớp với deviceModes ở Backend) ---
+enum DeviceMode : uint8_t {
+  MODE_AUTO = 0,      // Tự động theo sensor
+  MODE_MANUAL = 1,    // Thủ công qua MQTT command
+  MODE_SCHEDULE = 2,  // Theo lịch từ Backend
+  MODE_OFF = 3,       // Tắt hẳn: bơm luôn tắt
+};
+
+const int CONFIG_MAX_SCHEDULES = 8;
+
+// Một mục lịch tưới (startTime "HH:mm" -> số phút từ 0h)
+struct ScheduleEntry {
+  uint16_t startMinute;  // 0..1439
+  uint16_t durationMin;  // 1..1440
+  uint8_t daysMask;      // bit 0 = Chủ nhật ... bit 6 = Thứ bảy
+  uint8_t active;
+};
+
+// Ngưỡng điều khiển tự động (trước đây hard-code trong Control.h)
+struct ControlThresholds {
+  uint8_t soilDry;       // Đất khô dưới mức này (%) -> bật bơm
+  uint8_t soilWet;       // Đất ẩm từ mức này (%) -> tắt bơm
+  uint8_t hotTemp;       // Nhiệt độ nóng (°C)
+  uint8_t dryHumidity;   // Độ ẩm không khí khô (%)
+};
+
+// Mode và ngưỡng riêng của một vùng tưới (v2)
+struct ZoneConfig {
+  uint8_t mode;                      // DeviceMode
+  ControlThresholds threshold;
+};
+
+/**
+ * Cấu hình thiết bị. CHỈ THÊM field mới vào CUỐI struct và tăng
+ * CONFIG_VERSION - blob cũ sẽ được migrate bằng cách giữ phần đầu
+ * và lấy giá trị mặc định cho phần mới.
+ */
+struct DeviceConfig {
+  uint8_t mode;                      // DeviceMode - bản sao của zones[0] (v1)
+  ControlThresholds threshold;       // Bản sao của zones[0] (v1)
+  uint32_t loopInterval;             // ms
+  uint32_t sensorPublishInterval;    // ms
+  uint32_t heartbeatInterval;        // ms
+  uint8_t scheduleCount;
+  ScheduleEntry schedules[CONFIG_MAX_SCHEDULES];
+  ZoneConfig zones[MAX_ZONES];       // v2: mode + ngưỡng từng vùng
+};
+
+// Header của blob trong NVS
+struct ConfigBlobHeader {
+  uint16_t magic;
+  uint8_t version;
+  uint8_t reserved;
+  uint16_t size;      // Kích thước phần DeviceConfig đã lưu
+  uint16_t reserved2;
+  uint32_t crc;       // CRC32 của phần DeviceConfig
+};
+
+const uint16_t CONFIG_MAGIC = 0xC0F1;
+const uint8_t CONFIG_VERSION = 2;
+const char* CONFIG_NVS_NAMESPACE = "devcfg";
+const char* CONFIG_NVS_KEY = "cfg";
+
+DeviceConfig deviceConfig;
+unsigned long configLoadMicros = 0;   // Thời gian nạp config lúc boot (µs)
+
+/**
+ * Giá trị mặc định (giống hành vi firmware trước đây)
+ */
+void setDefaultConfig(DeviceConfig& cfg) {
+  memset(&cfg, 0, sizeof(cfg));
+  cfg.mode = MODE_AUTO;
+  cfg.threshold.soilDry = 40;
+  cfg.threshold.soilWet = 80;
+  cfg.threshold.hotTemp = 35;
+  cfg.threshold.dryHumidity = 40;
+  cfg.loopInterval = LOOP_INTERVAL;
+  cfg.sensorPublishInterval = SENSOR_PUBLISH_INTERVAL;
+  cfg.heartbeatInterval = HEARTBEAT_INTERVAL;
+  cfg.scheduleCount = 0;
+  for (int z = 0; z < MAX_ZONES; z++) {
+    cfg.zones[z].mode = cfg.mode;
+    cfg.zones[z].threshold = cfg.threshold;
+  }
+}
+
+/**
+ * CRC32 (IEEE 802.3, dạng bitwise - blob nhỏ nên không cần bảng tra)
+ */
+uint32_t crc32(const uint8_t* data, size_t length) {
+  uint32_t crc = 0xFFFFFFFF;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+/**
+ * Kiểm tra giá trị hợp lệ, sửa các field sai về mặc định
+ */
+void sanitizeConfig(DeviceConfig& cfg) {
+  DeviceConfig def;
+  setDefaultConfig(def);
+  for (int z = 0; z < MAX_ZONES; z++) {
+    ZoneConfig& zone = cfg.zones[z];
+    if (zone.mode > MODE_OFF) zone.mode = def.mode;
+    if (zone.threshold.soilDry > 100 || zone.threshold.soilWet > 100 ||
+        zone.threshold.soilDry >= zone.threshold.soilWet) {
+      zone.threshold.soilDry = def.threshold.soilDry;
+      zone.threshold.soilWet = def.threshold.soilWet;
+    }
+  }
+  // Field v1 luôn phản ánh vùng 0 (status "mode", Backend cũ)
+  cfg.mode = cfg.zones[0].mode;
+  cfg.threshold = cfg.zones[0].threshold;
+  if (cfg.loopInterval < 1000) cfg.loopInterval = def.loopInterval;
+  if (cfg.sensorPublishInterval < 1000) cfg.sensorPublishInterval = def.sensorPublishInterval;
+  if (cfg.heartbeatInterval < 1000) cfg.heartbeatInterval = def.heartbeatInterval;
+  if (cfg.scheduleCount > CONFIG_MAX_SCHEDULES) cfg.scheduleCount = 0;
+  for (int i = 0; i < cfg.scheduleCount; i++) {
+    const ScheduleEntry& entry = cfg.schedules[i];
+    if (entry.startMinute >= 1440 || entry.durationMin == 0 || entry.durationMin > 1440) {
+      cfg.scheduleCount = 0;  // Lịch hỏng: bỏ cả danh sách, đợi Backend gửi lại
+      break;
+    }
+  }
+}
+
+/**
+ * Migrate blob version cũ. Layout chỉ được nối thêm ở cuối, nên phần đầu
+ * (oldSize byte) đã được copy đè lên giá trị mặc định trước khi gọi hàm này.
+ * Thêm case khi có version mới cần chuyển đổi ý nghĩa field.
+ */
+void migrateConfig(DeviceConfig& cfg, uint8_t fromVersion) {
+  switch (fromVersion) {
+    case 1:
+      // v1 chỉ có một mode/ngưỡng: áp dụng cho mọi vùng
+      for (int z = 0; z < MAX_ZONES; z++) {
+        cfg.zones[z].mode = cfg.mode;
+        cfg.zones[z].threshold = cfg.threshold;
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+/**
+ * Nạp config từ NVS. Lỗi (chưa có, sai magic, sai CRC, version mới hơn firmware)
+ * -> dùng mặc định.
+ * @return true nếu nạp được từ NVS
+ */
+bool loadDeviceConfig() {
+  unsigned long start = micros();
+  setDefaultConfig(deviceConfig);
+
+  uint8_t blob[sizeof(ConfigBlobHeader) + sizeof(DeviceConfig)];
+  Preferences prefs;
+  size_t length = 0;
+  if (prefs.begin(CONFIG_NVS_NAMESPACE, true)) {
+    length = prefs.getBytes(CONFIG_NVS_KEY, blob, sizeof(blob));
+    prefs.end();
+  }
+
+  bool loaded = false;
+  ConfigBlobHeader header;
+  if (length >= sizeof(header)) {
+    memcpy(&header, blob, sizeof(header));
+    const uint8_t* payload = blob + sizeof(header);
+    if (header.magic != CONFIG_MAGIC) {
+      Serial.println("⚠️  Config: bad magic, using defaults");
+    } else if (header.version > CONFIG_VERSION) {
+      Serial.println("⚠️  Config: newer version than firmware, using defaults");
+    } else if (header.size > sizeof(DeviceConfig) || length < sizeof(header) + header.size) {
+      Serial.println("⚠️  Config: bad size, using defaults");
+    } else if (crc32(payload, header.size) != header.crc) {
+      Serial.println("⚠️  Config: CRC mismatch, using defaults");
+    } else {
+      memcpy(&deviceConfig, payload, header.size);
+      if (header.version < CONFIG_VERSION) {
+        migrateConfig(deviceConfig, header.version);
+        Serial.print("🔄 Config migrated from v");
+        Serial.println(header.version);
+      }
+      loaded = true;
+    }
+  }
+
+  sanitizeConfig(deviceConfig);
+  configLoadMicros = micros() - start;
+
+  Serial.print(loaded ? "✅ Config loaded from NVS" : "📋 Config: defaults");
+  Serial.print(" (");
+  Serial.print(configLoadMicros);
+  Serial.println(" us)");
+  return loaded;
+}
+
+/**
+ * Ghi config xuống NVS (chỉ gọi khi có thay đổi thật để tránh mòn flash)
+ */
+bool saveDeviceConfig() {
+  uint8_t blob[sizeof(ConfigBlobHeader) + sizeof(DeviceConfig)];
+  ConfigBlobHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic = CONFIG_MAGIC;
+  header.version = CONFIG_VERSION;
+  header.size = sizeof(DeviceConfig);
+  header.crc = crc32((const uint8_t*)&deviceConfig, sizeof(DeviceConfig));
+  memcpy(blob, &header, sizeof(header));
+  memcpy(blob + sizeof(header), &deviceConfig, sizeof(DeviceConfig));
+
+  Preferences prefs;
+  if (!prefs.begin(CONFIG_NVS_NAMESPACE, false)) {
+    Serial.println("❌ Config: cannot open NVS");
+    return false;
+  }
+  size_t written = prefs.putBytes(CONFIG_NVS_KEY, blob, sizeof(blob));
+  prefs.end();
+
+  if (written != sizeof(blob)) {
+    Serial.println("❌ Config: NVS write failed");
+    return false;
+  }
+  Serial.println("💾 Config saved to NVS");
+  return true;
+}
+
+const char* modeToString(uint8_t mode) {
+  switch (mode) {
+    case MODE_AUTO: return "auto";
+    case MODE_MANUAL: return "manual";
+    case MODE_SCHEDULE: return "schedule";
+    case MODE_OFF: return "off";
+  }
+  return "unknown";
+}
+
+/**
+ * @return true nếu chuỗi là mode hợp lệ (kết quả ghi vào out)
+ */
+bool parseMode(const String& value, uint8_t& out) {
+  if (value == "auto") { out = MODE_AUTO; return true; }
+  if (value == "manual") { out = MODE_MANUAL; return true; }
+  if (value == "schedule") { out = MODE_SCHEDULE; return true; }
+  if (value == "off") { out = MODE_OFF; return true; }
+  return false;
+}
+
+#endif
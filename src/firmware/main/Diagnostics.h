@@ -0,0 +1,29 @@
+/**
+ * Diagnostics Module
+ * Số liệu chẩn đoán runtime, gửi định kỳ qua topic diagnostics
+ */
+
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <Arduino.h>
+
+struct DiagnosticsMetrics {
+  unsigned long rainEvents;          // Số lần đổi trạng thái mưa (đã lọc dội)
+  unsigned long lastIrqToRelayUs;    // Ngắt mưa -> relay được đánh giá lại (µs), lần gần nhất
+  unsigned long maxIrqToRelayUs;
+  unsigned long sumIrqToRelayUs;     // Để tính trung bình
+};
+
+DiagnosticsMetrics diagnostics;
+
+void recordIrqToRelay(unsigned long latencyUs) {
+  diagnostics.rainEvents++;
+  diagnostics.lastIrqToRelayUs = latencyUs;
+  diagnostics.sumIrqToRelayUs += latencyUs;
+  if (latencyUs > diagnostics.maxIrqToRelayUs) {
+    diagnostics.maxIrqToRelayUs = latencyUs;
+  }
+}
+
+#endif
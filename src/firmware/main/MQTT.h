@@ -10,16 +10,44 @@
 #include <WiFi.h>
 #include <Arduino_JSON.h>
 #include "Config.h"
+#include "Actuators.h"
+#include "DeviceConfig.h"
+#include "Diagnostics.h"
+#include "Sensors.h"
+#include "Provisioning.h"
+
+// --- TOPIC ---
+// Các phần cố định của topic là hằng lúc biên dịch; chỉ deviceId (từ NVS) được
+// ghép một lần trong setupMQTT() vào buffer cố định, không tạo String mỗi lần publish.
+const char TOPIC_PREFIX[] = "iot/device/";
+const char TOPIC_SENSOR_DATA[] = "/sensor/data";
+const char TOPIC_STATUS[] = "/status";
+const char TOPIC_HEARTBEAT[] = "/heartbeat";   // Trạng thái relay (backend nhận qua heartbeat)
+const char TOPIC_COMMAND[] = "/command";
+const char TOPIC_CONFIG[] = "/config";
+const char TOPIC_FIRMWARE[] = "/firmware/update";
+const char TOPIC_EVENT[] = "/event";
+const char TOPIC_DIAGNOSTICS[] = "/diagnostics";
+
+// Đủ cho hậu tố dài nhất (TOPIC_FIRMWARE)
+const size_t TOPIC_MAX = sizeof(TOPIC_PREFIX) + DEVICE_ID_MAX + sizeof(TOPIC_FIRMWARE);
+
+struct DeviceTopics {
+  char sensorData[TOPIC_MAX];
+  char status[TOPIC_MAX];
+  char heartbeat[TOPIC_MAX];
+  char command[TOPIC_MAX];
+  char config[TOPIC_MAX];
+  char firmware[TOPIC_MAX];
+  char event[TOPIC_MAX];
+  char diagnostics[TOPIC_MAX];
+};
 
 // Forward declarations (khai báo trong main.ino)
 extern WiFiClient espClient;
 extern PubSubClient mqttClient;
-extern String topicSensorData;
-extern String topicStatus;
-extern String topicPumpStatus;
-extern String topicCommand;
-extern String topicConfig;
-extern String topicFirmware;
+extern DeviceTopics topics;
+extern unsigned long bootToControlMs;
 
 // Forward declarations cho các hàm (phải khai báo trước khi sử dụng)
 void handleCommand(String message);
@@ -29,105 +57,113 @@ void publishStatus(String status);
 void reconnectMQTT();
 void mqttCallback(char* topic, byte* payload, unsigned int length);
 
+void buildTopic(char* out, const char* suffix) {
+  snprintf(out, TOPIC_MAX, "%s%s%s", TOPIC_PREFIX, identity.deviceId, suffix);
+}
+
 /**
- * Khởi tạo MQTT
+ * Khởi tạo MQTT: topics, transport, server (chỉ cần identity, không cần WiFi).
+ * Gọi một lần trong setup() sau loadIdentity(); kết nối do reconnectMQTT() đảm nhận,
+ * nên WiFi lên muộn sau boot vẫn kết nối với đúng topic/server.
  */
 void setupMQTT() {
-  // Kiểm tra WiFi trước
-  if (WiFi.status() != WL_CONNECTED) {
-    Serial.println("WiFi not connected. Cannot setup MQTT.");
-    return;
-  }
-  
   // Khởi tạo topics
-  topicSensorData = "iot/device/" + String(deviceId) + "/sensor/data";
-  topicStatus = "iot/device/" + String(deviceId) + "/status";
-  topicPumpStatus = "iot/device/" + String(deviceId) + "/heartbeat"; // Dùng heartbeat topic để backend nhận được
-  topicCommand = "iot/device/" + String(deviceId) + "/command";
-  topicConfig = "iot/device/" + String(deviceId) + "/config";
-  topicFirmware = "iot/device/" + String(deviceId) + "/firmware/update";
+  buildTopic(topics.sensorData, TOPIC_SENSOR_DATA);
+  buildTopic(topics.status, TOPIC_STATUS);
+  buildTopic(topics.heartbeat, TOPIC_HEARTBEAT);
+  buildTopic(topics.command, TOPIC_COMMAND);
+  buildTopic(topics.config, TOPIC_CONFIG);
+  buildTopic(topics.firmware, TOPIC_FIRMWARE);
+  buildTopic(topics.event, TOPIC_EVENT);
+  buildTopic(topics.diagnostics, TOPIC_DIAGNOSTICS);
   
   // Cấu hình MQTT client
-  mqttClient.setServer(mqtt_broker, mqtt_port);
+  mqttClient.setServer(identity.broker, identity.port);
   mqttClient.setCallback(mqttCallback);
   mqttClient.setBufferSize(1024); // Tăng buffer size
   mqttClient.setKeepAlive(60); // Keepalive 60 giây
+  mqttClient.setSocketTimeout(MQTT_SOCKET_TIMEOUT_S); // Giới hạn thời gian chặn khi chờ CONNACK
   
   Serial.print("📡 MQTT configured: ");
-  Serial.print(mqtt_broker);
+  Serial.print(identity.broker);
   Serial.print(":");
-  Serial.println(mqtt_port);
-  
-  // Kết nối
-  reconnectMQTT();
+  Serial.println(identity.port);
 }
 
+unsigned long lastMqttAttempt = 0;   // millis() lần thử kết nối gần nhất
+bool mqttAttempted = false;
+
 /**
- * Kết nối lại MQTT nếu mất kết nối
+ * Kết nối lại MQTT nếu mất kết nối - không chặn: mỗi lần gọi thử tối đa một lần,
+ * cách lần trước ít nhất MQTT_RETRY_INTERVAL, nên loop() (sự kiện mưa, điều khiển)
+ * vẫn chạy giữa các lần thử khi mất WiFi/broker.
  */
 void reconnectMQTT() {
-  // Kiểm tra WiFi trước
-  if (WiFi.status() != WL_CONNECTED) {
-    Serial.println("WiFi not connected. Reconnecting...");
-    setupWiFi();
-    if (WiFi.status() != WL_CONNECTED) {
-      Serial.println("WiFi connection failed. Cannot connect to MQTT.");
-      return;
-    }
+  if (mqttClient.connected()) {
+    return;
   }
+  // Kiểm tra WiFi trước (WiFi tự kết nối lại, xem wifiReady())
+  if (!wifiReady()) {
+    return;
+  }
+  if (mqttAttempted && millis() - lastMqttAttempt < MQTT_RETRY_INTERVAL) {
+    return;
+  }
+  mqttAttempted = true;
+  lastMqttAttempt = millis();
+  
+  Serial.print("🔌 Connecting to MQTT broker (");
+  Serial.print(identity.broker);
+  Serial.print(":");
+  Serial.print(identity.port);
+  Serial.print(")...");
+  
+  char clientId[sizeof("ESP32-") + DEVICE_ID_MAX + 5];
+  snprintf(clientId, sizeof(clientId), "ESP32-%s-%x", identity.deviceId, (unsigned)random(0xffff));
+  Serial.print(" ClientID: ");
+  Serial.print(clientId);
+  Serial.print(" ... ");
   
-  while (!mqttClient.connected()) {
-    Serial.print("🔌 Connecting to MQTT broker (");
-    Serial.print(mqtt_broker);
-    Serial.print(":");
-    Serial.print(mqtt_port);
-    Serial.print(")...");
+  // Thử kết nối với timeout
+  bool connected = mqttClient.connect(clientId);
+  
+  if (connected) {
+    Serial.println("✅ MQTT connected");
+    
+    // Subscribe topics để nhận lệnh (vùng nằm trong payload, không cần topic riêng).
+    // Không dùng wildcard iot/device/<id>/+: nó nhận lại cả status/heartbeat/event/
+    // diagnostics chính thiết bị publish, gấp đôi lưu lượng broker -> thiết bị.
+    mqttClient.subscribe(topics.command);
+    mqttClient.subscribe(topics.config);
+    mqttClient.subscribe(topics.firmware);
+    Serial.println("📡 Subscribed to command topics");
     
-    String clientId = "ESP32-" + String(deviceId) + "-" + String(random(0xffff), HEX);
-    Serial.print(" ClientID: ");
-    Serial.print(clientId);
-    Serial.print(" ... ");
+    // Gửi trạng thái online
+    publishStatus("online");
     
-    // Thử kết nối với timeout
-    bool connected = mqttClient.connect(clientId.c_str());
+  } else {
+    int state = mqttClient.state();
+    Serial.print("Failed, rc=");
+    Serial.print(state);
     
-    if (connected) {
-      Serial.println("✅ MQTT connected");
-      
-      // Subscribe topics để nhận lệnh
-      mqttClient.subscribe(topicCommand.c_str());
-      mqttClient.subscribe(topicConfig.c_str());
-      mqttClient.subscribe(topicFirmware.c_str());
-      Serial.println("📡 Subscribed to command topics");
-      
-      // Gửi trạng thái online
-      publishStatus("online");
-      
-    } else {
-      int state = mqttClient.state();
-      Serial.print("Failed, rc=");
-      Serial.print(state);
-      
-      // Giải thích mã lỗi
-      switch(state) {
-        case -4: Serial.print(" (MQTT_CONNECTION_TIMEOUT)"); break;
-        case -3: Serial.print(" (MQTT_CONNECTION_LOST)"); break;
-        case -2: Serial.print(" (MQTT_CONNECT_FAILED)"); break;
-        case -1: Serial.print(" (MQTT_DISCONNECTED)"); break;
-        case 1: Serial.print(" (MQTT_CONNECT_BAD_PROTOCOL)"); break;
-        case 2: Serial.print(" (MQTT_CONNECT_BAD_CLIENT_ID)"); break;
-        case 3: Serial.print(" (MQTT_CONNECT_UNAVAILABLE)"); break;
-        case 4: Serial.print(" (MQTT_CONNECT_BAD_CREDENTIALS)"); break;
-        case 5: Serial.print(" (MQTT_CONNECT_UNAUTHORIZED)"); break;
-      }
-      
-      Serial.print(" | WiFi Status: ");
-      Serial.print(WiFi.status());
-      Serial.print(" | IP: ");
-      Serial.print(WiFi.localIP());
-      Serial.println(" | Retrying in 5 seconds...");
-      delay(5000);
+    // Giải thích mã lỗi
+    switch(state) {
+      case -4: Serial.print(" (MQTT_CONNECTION_TIMEOUT)"); break;
+      case -3: Serial.print(" (MQTT_CONNECTION_LOST)"); break;
+      case -2: Serial.print(" (MQTT_CONNECT_FAILED)"); break;
+      case -1: Serial.print(" (MQTT_DISCONNECTED)"); break;
+      case 1: Serial.print(" (MQTT_CONNECT_BAD_PROTOCOL)"); break;
+      case 2: Serial.print(" (MQTT_CONNECT_BAD_CLIENT_ID)"); break;
+      case 3: Serial.print(" (MQTT_CONNECT_UNAVAILABLE)"); break;
+      case 4: Serial.print(" (MQTT_CONNECT_BAD_CREDENTIALS)"); break;
+      case 5: Serial.print(" (MQTT_CONNECT_UNAUTHORIZED)"); break;
     }
+    
+    Serial.print(" | WiFi Status: ");
+    Serial.print(WiFi.status());
+    Serial.print(" | IP: ");
+    Serial.print(WiFi.localIP());
+    Serial.println(" | Retrying in 5 seconds...");
   }
 }
 
@@ -137,7 +173,7 @@ void reconnectMQTT() {
 void mqttCallback(char* topic, byte* payload, unsigned int length) {
   // Convert payload to string
   String message = "";
-  for (int i = 0; i < length; i++) {
+  for (unsigned int i = 0; i < length; i++) {
     message += (char)payload[i];
   }
   
@@ -147,19 +183,22 @@ void mqttCallback(char* topic, byte* payload, unsigned int length) {
   Serial.println(message);
   
   // Parse JSON và xử lý lệnh
-  if (String(topic) == topicCommand) {
+  if (strcmp(topic, topics.command) == 0) {
     handleCommand(message);
-  } else if (String(topic) == topicConfig) {
+  } else if (strcmp(topic, topics.config) == 0) {
     handleConfig(message);
-  } else if (String(topic) == topicFirmware) {
+  } else if (strcmp(topic, topics.firmware) == 0) {
     handleFirmwareUpdate(message);
   }
 }
 
 /**
- * Gửi dữ liệu sensor qua MQTT
+ * Gửi dữ liệu sensor qua MQTT - một message cho tất cả vùng mỗi chu kỳ
+ * Payload: { temperature, humidity, soilMoisture (vùng 0), isRain,
+ *            zones: [{ zone, soilMoisture, pump, mode }] (chỉ khi board có > 1 vùng) }
+ * @param soilMoisture Độ ẩm đất từng vùng (%)
  */
-void publishSensorData(int temperature, int humidity, int soilMoisture, bool isRain) {
+void publishSensorData(int temperature, int humidity, const int* soilMoisture, bool isRain) {
   if (!mqttClient.connected()) {
     return;
   }
@@ -170,14 +209,26 @@ void publishSensorData(int temperature, int humidity, int soilMoisture, bool isR
   JSONVar doc;
   doc["temperature"] = temperature;
   doc["humidity"] = humidity;
-  doc["soilMoisture"] = soilMoisture;
+  doc["soilMoisture"] = soilMoisture[0];
   doc["isRain"] = isRain;
+  if (ZONE_COUNT > 1) {
+    JSONVar zones;
+    for (int z = 0; z < ZONE_COUNT; z++) {
+      JSONVar item;
+      item["zone"] = z;
+      item["soilMoisture"] = soilMoisture[z];
+      item["pump"] = isActuatorOn(zoneActuator(z));
+      item["mode"] = modeToString(deviceConfig.zones[z].mode);
+      zones[z] = item;
+    }
+    doc["zones"] = zones;
+  }
   // Không gửi timestamp - backend sẽ tự tạo để đảm bảo chính xác
   
   String payload = JSON.stringify(doc);
   
   // Publish
-  if (mqttClient.publish(topicSensorData.c_str(), payload.c_str())) {
+  if (mqttClient.publish(topics.sensorData, payload.c_str())) {
     Serial.println("Sensor data published");
   } else {
     Serial.println("Failed to publish sensor data");
@@ -194,34 +245,78 @@ void publishStatus(String status) {
   
   JSONVar doc;
   doc["status"] = status;
+  doc["mode"] = modeToString(deviceConfig.mode);
+  doc["zoneCount"] = ZONE_COUNT;
+  doc["configLoadUs"] = (int)configLoadMicros;
+  doc["bootToControlMs"] = (int)bootToControlMs;
   doc["timestamp"] = (int)millis();
   
   String payload = JSON.stringify(doc);
   
-  mqttClient.publish(topicStatus.c_str(), payload.c_str());
+  mqttClient.publish(topics.status, payload.c_str());
 }
 
 /**
- * Gửi heartbeat
+ * Gửi heartbeat kèm trạng thái tất cả relay
+ * Payload: { "relay1Status": bool, "relays": bitmask, "timestamp": ms }
+ * relays: bit i = kênh i (actuatorDef(i)) đang bật
  */
 void publishPumpStatus() {
   if (!mqttClient.connected()) {
     return;
   }
   
-  // Đọc trạng thái relay1 (LOW = đang hoạt động, HIGH = tắt)
-  int relay1State = digitalRead(PIN_RELAY_1);
-  bool relay1Active = (relay1State == LOW); // LOW = đang hoạt động
-  
   JSONVar doc;
-  doc["relay1Status"] = relay1Active; // true = đang hoạt động (LOW), false = tắt (HIGH)
+  doc["relay1Status"] = isActuatorOn(ACTUATOR_PUMP); // true = đang hoạt động, false = tắt
+  doc["relays"] = (int)actuatorStateMask();
   doc["timestamp"] = (int)millis();
   String payload = JSON.stringify(doc);
   
-  // Debug: Log payload trước khi gửi
+  mqttClient.publish(topics.heartbeat, payload.c_str());
+}
+
+/**
+ * Gửi sự kiện mưa/tạnh ngay khi phát hiện
+ * Payload: { event: "rain_start" | "rain_stop", previousStateMs, irqToRelayUs, rainMsTotal, dryMsTotal }
+ */
+void publishRainEvent(unsigned long previousStateMs, unsigned long irqToRelayUs) {
+  if (!mqttClient.connected()) {
+    return;
+  }
+  
+  JSONVar doc;
+  doc["event"] = rainState.raining ? "rain_start" : "rain_stop";
+  doc["previousStateMs"] = (int)previousStateMs;
+  doc["irqToRelayUs"] = (int)irqToRelayUs;
+  doc["rainMsTotal"] = (int)rainState.rainMsTotal;
+  doc["dryMsTotal"] = (int)rainState.dryMsTotal;
+  doc["timestamp"] = (int)millis();
+  
+  String payload = JSON.stringify(doc);
+  mqttClient.publish(topics.event, payload.c_str());
+}
 
+/**
+ * Gửi số liệu chẩn đoán (chu kỳ heartbeatInterval)
+ */
+void publishDiagnostics() {
+  if (!mqttClient.connected()) {
+    return;
+  }
+  
+  unsigned long inState = millis() - rainState.since;
+  
+  JSONVar doc;
+  doc["rainEvents"] = (int)diagnostics.rainEvents;
+  doc["irqToRelayLastUs"] = (int)diagnostics.lastIrqToRelayUs;
+  doc["irqToRelayMaxUs"] = (int)diagnostics.maxIrqToRelayUs;
+  doc["irqToRelayAvgUs"] = diagnostics.rainEvents > 0 ? (int)(diagnostics.sumIrqToRelayUs / diagnostics.rainEvents) : 0;
+  doc["rainMsTotal"] = (int)(rainState.rainMsTotal + (rainState.raining ? inState : 0));
+  doc["dryMsTotal"] = (int)(rainState.dryMsTotal + (rainState.raining ? 0 : inState));
+  doc["timestamp"] = (int)millis();
   
-  mqttClient.publish(topicPumpStatus.c_str(), payload.c_str());
+  String payload = JSON.stringify(doc);
+  mqttClient.publish(topics.diagnostics, payload.c_str());
 }
 
 #endif
@@ -11,12 +11,113 @@
 #include <Update.h>
 #include <WiFi.h>
 #include "Config.h"
+#include "Actuators.h"
+#include "DeviceConfig.h"
 
 // Forward declaration
+void publishPumpStatus();
 void performOTAUpdate(String firmwareUrl, int expectedSize, String version);
+void pollSensorEvents();
+
+/**
+ * Đọc thời gian xung (ms) từ một object JSON, giới hạn ACTUATOR_MAX_PULSE_MS
+ */
+unsigned long parseDuration(JSONVar item) {
+  if (!item.hasOwnProperty("duration") || JSON.typeof(item["duration"]) != "number") {
+    return 0;
+  }
+  long duration = (long)item["duration"];
+  if (duration <= 0) {
+    return 0;
+  }
+  return min((unsigned long)duration, ACTUATOR_MAX_PULSE_MS);
+}
+
+/**
+ * Đọc field "zone" (chỉ số vùng tưới) nếu có
+ * @param zone -1 nếu không có field
+ * @return false nếu field có nhưng không phải vùng hợp lệ của board
+ */
+bool readZoneField(JSONVar obj, int& zone) {
+  zone = -1;
+  if (!obj.hasOwnProperty("zone")) {
+    return true;
+  }
+  if (JSON.typeof(obj["zone"]) != "number") {
+    return false;
+  }
+  zone = (int)obj["zone"];
+  return zone >= 0 && zone < ZONE_COUNT;
+}
+
+/**
+ * Phân tích action dạng "<kênh>_on" / "<kênh>_off" (vd: "pump_on", "relay2_off")
+ */
+bool parseLegacyAction(const String& action, ActuatorAction& out) {
+  int sep = action.lastIndexOf('_');
+  if (sep <= 0) {
+    return false;
+  }
+  String state = action.substring(sep + 1);
+  if (state != "on" && state != "off") {
+    return false;
+  }
+  out.channel = findActuator(action.substring(0, sep));
+  out.on = (state == "on");
+  out.duration = 0;
+  return out.channel >= 0;
+}
+
+/**
+ * Phân tích một phần tử trong mảng "actions"
+ * Dạng: { "channel": "pump" | 0, "state": "on" | "off" | true | false, "duration": ms }
+ *  hoặc: { "zone": 1, "state": ..., "duration": ms } - bơm của vùng 1
+ */
+bool parseBatchAction(JSONVar item, ActuatorAction& out) {
+  int zone = -1;
+  if (!readZoneField(item, zone) || !item.hasOwnProperty("state")) {
+    return false;
+  }
+
+  String channelType = JSON.typeof(item["channel"]);
+  if (zone >= 0) {
+    out.channel = zoneActuator(zone);
+  } else if (channelType == "number") {
+    out.channel = (int)item["channel"];
+  } else if (channelType == "string") {
+    out.channel = findActuator(String((const char*)item["channel"]));
+  } else {
+    return false;
+  }
+  if (!isActuatorAvailable(out.channel)) {
+    return false;
+  }
+
+  String stateType = JSON.typeof(item["state"]);
+  if (stateType == "boolean") {
+    out.on = (bool)item["state"];
+  } else if (stateType == "string") {
+    String state = (const char*)item["state"];
+    if (state != "on" && state != "off") {
+      return false;
+    }
+    out.on = (state == "on");
+  } else {
+    return false;
+  }
+
+  out.duration = parseDuration(item);
+  return true;
+}
 
 /**
  * Xử lý lệnh điều khiển từ Backend
+ * Hỗ trợ 2 dạng:
+ *  - Đơn lẻ: { "action": "pump_on", "duration": 30000 }
+ *  - Batch:  { "actions": [ { "channel": "pump", "state": "on", "duration": 30000 },
+ *                           { "channel": "relay2", "state": "off" } ] }
+ * Theo vùng: { "zone": 1, "action": "pump_on" } hoặc phần tử batch { "zone": 1, "state": "on" }
+ * Batch được kiểm tra toàn bộ trước, chỉ áp dụng khi mọi phần tử hợp lệ.
  * @param message JSON string chứa lệnh
  */
 void handleCommand(String message) {
@@ -28,28 +129,219 @@ void handleCommand(String message) {
     return;
   }
   
-  // Xử lý lệnh
-  if (doc.hasOwnProperty("action")) {
+  ActuatorAction actions[ACTUATOR_COUNT] = {};
+  int count = 0;
+  
+  if (doc.hasOwnProperty("actions")) {
+    JSONVar list = doc["actions"];
+    if (JSON.typeof(list) != "array") {
+      Serial.println("❌ 'actions' must be an array");
+      return;
+    }
+    int length = list.length();
+    if (length > ACTUATOR_COUNT) {
+      Serial.println("❌ Too many actions in batch");
+      return;
+    }
+    for (int i = 0; i < length; i++) {
+      if (!parseBatchAction(list[i], actions[count])) {
+        Serial.print("❌ Invalid action at index ");
+        Serial.print(i);
+        Serial.println(", batch rejected");
+        return;
+      }
+      count++;
+    }
+  } else if (doc.hasOwnProperty("action")) {
     String action = (const char*)doc["action"];
+    int zone = -1;
+    if (!readZoneField(doc, zone)) {
+      Serial.println("❌ Invalid zone");
+      return;
+    }
+    if (!parseLegacyAction(action, actions[0]) || (zone >= 0 && actions[0].channel != ACTUATOR_PUMP)) {
+      Serial.print("⚠️  Unknown action: ");
+      Serial.println(action);
+      return;
+    }
+    if (zone >= 0) {
+      actions[0].channel = zoneActuator(zone);  // "pump_*" của vùng được chỉ định
+    }
+    actions[0].duration = actions[0].on ? parseDuration(doc) : 0;
+    count = 1;
+  } else {
+    return;
+  }
+  
+  applyActuatorActions(actions, count);
+  
+  for (int i = 0; i < count; i++) {
+    Serial.print("✅ ");
+    Serial.print(actuatorDef(actions[i].channel).name);
+    Serial.print(actions[i].on ? " ON" : " OFF");
+    if (actions[i].duration > 0) {
+      Serial.print(" for ");
+      Serial.print(actions[i].duration);
+      Serial.print(" ms");
+    }
+    Serial.println(" (via MQTT)");
+  }
+  
+  // Báo trạng thái mới ngay, không đợi chu kỳ LOOP_INTERVAL
+  publishPumpStatus();
+}
+
+/**
+ * Đọc số nguyên trong khoảng [lo, hi] từ object JSON
+ * @return true nếu field tồn tại và hợp lệ
+ */
+bool readConfigNumber(JSONVar obj, const char* key, long lo, long hi, long& out) {
+  if (!obj.hasOwnProperty(key) || JSON.typeof(obj[key]) != "number") {
+    return false;
+  }
+  long value = (long)obj[key];
+  if (value < lo || value > hi) {
+    Serial.print("⚠️  Config value out of range: ");
+    Serial.println(key);
+    return false;
+  }
+  out = value;
+  return true;
+}
+
+/**
+ * Phân tích giờ "HH:mm" (hoặc "H:mm") thành số phút từ 0h
+ * @return false nếu sai định dạng hoặc ngoài 00:00..23:59
+ */
+bool parseTimeOfDay(const char* text, uint16_t& minuteOfDay) {
+  int length = strlen(text);
+  int sep = length - 3;
+  if ((length != 4 && length != 5) || text[sep] != ':') {
+    return false;
+  }
+  for (int i = 0; i < length; i++) {
+    if (i != sep && !isdigit((unsigned char)text[i])) {
+      return false;
+    }
+  }
+  int hour = atoi(text);
+  int minute = atoi(text + sep + 1);
+  if (hour > 23 || minute > 59) {
+    return false;
+  }
+  minuteOfDay = hour * 60 + minute;
+  return true;
+}
+
+/**
+ * Đọc danh sách lịch: [{ startTime: "HH:mm", duration: phút, daysOfWeek: [0..6], isActive }]
+ * Mục sai định dạng bị bỏ qua (không ghi xuống NVS).
+ */
+void readConfigSchedules(JSONVar list, DeviceConfig& cfg) {
+  int count = min(list.length(), CONFIG_MAX_SCHEDULES);
+  memset(cfg.schedules, 0, sizeof(cfg.schedules));
+  cfg.scheduleCount = 0;
+  
+  for (int i = 0; i < count; i++) {
+    JSONVar item = list[i];
+    if (!item.hasOwnProperty("startTime") || JSON.typeof(item["startTime"]) != "string") {
+      continue;
+    }
+    uint16_t startMinute = 0;
+    long duration = 0;
+    if (!parseTimeOfDay((const char*)item["startTime"], startMinute)) {
+      Serial.print("⚠️  Invalid schedule startTime at index ");
+      Serial.println(i);
+      continue;
+    }
+    if (!readConfigNumber(item, "duration", 1, 1440, duration)) {
+      continue;
+    }
     
-    if (action == "pump_on") {
-      digitalWrite(PIN_RELAY_1, LOW);
-      Serial.println("✅ Pump turned ON (via MQTT)");
-    } else if (action == "pump_off") {
-      digitalWrite(PIN_RELAY_1, HIGH);
-      Serial.println("✅ Pump turned OFF (via MQTT)");
-    } else if (action == "relay2_on") {
-      digitalWrite(PIN_RELAY_2, LOW);
-      Serial.println("✅ Relay 2 turned ON (via MQTT)");
-    } else if (action == "relay2_off") {
-      digitalWrite(PIN_RELAY_2, HIGH);
-      Serial.println("✅ Relay 2 turned OFF (via MQTT)");
+    ScheduleEntry& entry = cfg.schedules[cfg.scheduleCount++];
+    entry.startMinute = startMinute;
+    entry.durationMin = duration;
+    entry.active = !item.hasOwnProperty("isActive") || (bool)item["isActive"];
+    if (item.hasOwnProperty("daysOfWeek") && JSON.typeof(item["daysOfWeek"]) == "array") {
+      JSONVar days = item["daysOfWeek"];
+      for (int d = 0; d < days.length(); d++) {
+        int day = (int)days[d];
+        if (day >= 0 && day <= 6) {
+          entry.daysMask |= (1 << day);
+        }
+      }
+    } else {
+      entry.daysMask = 0x7F; // Mặc định: tất cả các ngày
+    }
+  }
+}
+
+/**
+ * Đọc mode/threshold từ object JSON vào cấu hình một vùng
+ */
+void readZoneConfig(JSONVar obj, ZoneConfig& zone) {
+  long value = 0;
+  
+  if (obj.hasOwnProperty("mode")) {
+    String newMode = (const char*)obj["mode"];
+    if (!parseMode(newMode, zone.mode)) {
+      Serial.print("⚠️  Invalid mode: ");
+      Serial.println(newMode);
+    }
+  }
+  
+  if (obj.hasOwnProperty("threshold")) {
+    JSONVar threshold = obj["threshold"];
+    ControlThresholds t = zone.threshold;
+    if (readConfigNumber(threshold, "soilDry", 0, 100, value)) t.soilDry = value;
+    if (readConfigNumber(threshold, "soilWet", 0, 100, value)) t.soilWet = value;
+    if (readConfigNumber(threshold, "hotTemp", 0, 80, value)) t.hotTemp = value;
+    if (readConfigNumber(threshold, "dryHumidity", 0, 100, value)) t.dryHumidity = value;
+    if (t.soilDry >= t.soilWet) {
+      Serial.println("⚠️  soilDry must be lower than soilWet, thresholds ignored");
+    } else {
+      zone.threshold = t;
     }
   }
 }
 
+/**
+ * Log mode mới của một vùng
+ */
+void logModeChange(int zone, uint8_t mode) {
+  if (ZONE_COUNT > 1) {
+    Serial.print("✅ Zone ");
+    Serial.print(zone);
+    Serial.print(" mode updated to: ");
+  } else {
+    Serial.print("✅ Mode updated to: ");
+  }
+  Serial.println(modeToString(mode));
+  
+  // Log giải thích mode
+  switch (mode) {
+    case MODE_MANUAL:
+      Serial.println("📌 Chế độ THỦ CÔNG: Logic tự động đã TẮT, chỉ điều khiển qua MQTT command");
+      break;
+    case MODE_AUTO:
+      Serial.println("📌 Chế độ TỰ ĐỘNG: Logic tự động đã BẬT, điều khiển dựa trên sensor");
+      break;
+    case MODE_SCHEDULE:
+      Serial.println("📌 Chế độ LỊCH TRÌNH: Logic tự động đã TẮT, điều khiển theo lịch từ Backend");
+      break;
+    case MODE_OFF:
+      Serial.println("📌 Chế độ TẮT: Bơm luôn tắt");
+      break;
+  }
+}
+
 /**
  * Xử lý cấu hình từ Backend
+ * Payload: { mode, threshold: { soilDry, soilWet, hotTemp, dryHumidity },
+ *            intervals: { loop, sensorPublish, heartbeat }, schedule: [...] }
+ * mode/threshold áp dụng cho mọi vùng, hoặc chỉ một vùng nếu có "zone": n.
+ * Nhiều vùng trong một message: { zones: [{ zone, mode, threshold }, ...] }
+ * Mọi field đều tùy chọn. Config chỉ được ghi xuống NVS khi thực sự thay đổi.
  * @param message JSON string chứa cấu hình
  */
 void handleConfig(String message) {
@@ -61,32 +353,61 @@ void handleConfig(String message) {
     return;
   }
   
-  // Cập nhật mode nếu có trong config
-  if (doc.hasOwnProperty("mode")) {
-    String newMode = (const char*)doc["mode"];
-    
-    // Validate mode
-    if (newMode == "auto" || newMode == "manual" || newMode == "schedule") {
-      // Khai báo extern để truy cập biến toàn cục từ Config.h
-      extern String deviceMode;
-      deviceMode = newMode;
-      Serial.print("✅ Mode updated to: ");
-      Serial.println(deviceMode);
-      
-      // Log giải thích mode
-      if (deviceMode == "manual") {
-        Serial.println("📌 Chế độ THỦ CÔNG: Logic tự động đã TẮT, chỉ điều khiển qua MQTT command");
-      } else if (deviceMode == "auto") {
-        Serial.println("📌 Chế độ TỰ ĐỘNG: Logic tự động đã BẬT, điều khiển dựa trên sensor");
-      } else if (deviceMode == "schedule") {
-        Serial.println("📌 Chế độ LỊCH TRÌNH: Logic tự động đã TẮT, điều khiển theo lịch từ Backend");
+  DeviceConfig next = deviceConfig;
+  long value = 0;
+  int zone = -1;
+  
+  // Mode/ngưỡng: một vùng (có "zone") hoặc tất cả vùng
+  if (!readZoneField(doc, zone)) {
+    Serial.println("⚠️  Invalid zone, mode/threshold ignored");
+  } else if (zone >= 0) {
+    readZoneConfig(doc, next.zones[zone]);
+  } else {
+    // Chỉ các vùng board có; board không tưới vẫn giữ mode ở vùng 0 (field v1)
+    int zoneCount = ZONE_COUNT > 0 ? ZONE_COUNT : 1;
+    for (int z = 0; z < zoneCount; z++) {
+      readZoneConfig(doc, next.zones[z]);
+    }
+  }
+  
+  if (doc.hasOwnProperty("zones") && JSON.typeof(doc["zones"]) == "array") {
+    JSONVar list = doc["zones"];
+    for (int i = 0; i < list.length(); i++) {
+      JSONVar item = list[i];
+      if (!readZoneField(item, zone) || zone < 0) {
+        Serial.print("⚠️  Invalid zone at index ");
+        Serial.println(i);
+        continue;
       }
-    } else {
-      Serial.print("⚠️  Invalid mode: ");
-      Serial.println(newMode);
+      readZoneConfig(item, next.zones[zone]);
+    }
+  }
+  sanitizeConfig(next);   // Đồng bộ mode/threshold v1 theo vùng 0
+  
+  if (doc.hasOwnProperty("intervals")) {
+    JSONVar intervals = doc["intervals"];
+    if (readConfigNumber(intervals, "loop", 1000, 3600000, value)) next.loopInterval = value;
+    if (readConfigNumber(intervals, "sensorPublish", 1000, 3600000, value)) next.sensorPublishInterval = value;
+    if (readConfigNumber(intervals, "heartbeat", 1000, 3600000, value)) next.heartbeatInterval = value;
+  }
+  
+  if (doc.hasOwnProperty("schedule") && JSON.typeof(doc["schedule"]) == "array") {
+    readConfigSchedules(doc["schedule"], next);
+  }
+  
+  if (memcmp(&next, &deviceConfig, sizeof(DeviceConfig)) == 0) {
+    Serial.println("📋 Config unchanged, NVS write skipped");
+    return;
+  }
+  
+  DeviceConfig previous = deviceConfig;
+  deviceConfig = next;
+  saveDeviceConfig();
+  
+  for (int z = 0; z < ZONE_COUNT; z++) {
+    if (deviceConfig.zones[z].mode != previous.zones[z].mode) {
+      logModeChange(z, deviceConfig.zones[z].mode);
     }
-  } else {
-    Serial.println("📋 Config received but no 'mode' field found");
   }
 }
 
@@ -303,7 +624,7 @@ void performOTAUpdate(String firmwareUrl, int expectedSize, String version) {
       if (c > 0) {
         // Write to flash
         size_t writtenBytes = Update.write(buffer, c);
-        if (writtenBytes != c) {
+        if (writtenBytes != (size_t)c) {
           Serial.print("❌ Flash write error! Expected: ");
           Serial.print(c);
           Serial.print(", Written: ");
@@ -332,7 +653,8 @@ void performOTAUpdate(String firmwareUrl, int expectedSize, String version) {
         }
       }
     } else {
-      // Không có data, đợi một chút
+      // Không có data, xử lý sự kiện cảm biến rồi đợi một chút
+      pollSensorEvents();
       delay(10);
     }
     
@@ -0,0 +1,213 @@
+/**
+ * Provisioning Module
+ * WiFi, broker và deviceId không còn nằm trong source: được nạp một lần vào
+ * NVS (namespace "prov") qua Serial, nên cùng một binary dùng được cho mọi
+ * thiết bị cùng loại board.
+ *
+ * Nạp qua Serial (115200), gửi một dòng JSON rồi Enter:
+ *   {"ssid":"...","password":"...","broker":"...","port":1883,"deviceId":"ESP32_001"}
+ * Chỉ các field có mặt được ghi; thiết bị khởi động lại sau khi lưu.
+ * Gửi {"reset":true} để xóa toàn bộ.
+ *
+ * NVS trống (lần boot đầu, kể cả sau OTA từ firmware cũ): nạp seed PROVISION_SSID/
+ * PROVISION_PASSWORD/PROVISION_DEVICE_ID (Config.h) rồi ghi xuống NVS.
+ */
+
+#ifndef PROVISIONING_H
+#define PROVISIONING_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <Arduino_JSON.h>
+#include "Config.h"
+
+const size_t DEVICE_ID_MAX = 31;
+const size_t PROVISION_LINE_MAX = 256;
+const char* PROV_NVS_NAMESPACE = "prov";
+
+struct DeviceIdentity {
+  char ssid[33];
+  char password[65];
+  char broker[65];
+  uint16_t port;
+  char deviceId[DEVICE_ID_MAX + 1];
+};
+
+DeviceIdentity identity;
+
+bool isProvisioned() {
+  return identity.ssid[0] != '\0';
+}
+
+/**
+ * deviceId mặc định khi chưa được cấp: "ESP32_" + 3 byte cuối MAC
+ */
+void defaultDeviceId(char* out, size_t size) {
+  uint64_t mac = ESP.getEfuseMac();
+  // eFuse MAC lưu little-endian: byte thấp nhất là byte đầu của địa chỉ
+  snprintf(out, size, "ESP32_%02X%02X%02X",
+           (unsigned)((mac >> 24) & 0xFF), (unsigned)((mac >> 32) & 0xFF), (unsigned)((mac >> 40) & 0xFF));
+}
+
+bool saveIdentity();
+
+/**
+ * Nạp thông tin thiết bị từ NVS, thiếu field nào dùng mặc định field đó.
+ * Namespace trống thì dùng seed PROVISION_* (Config.h) và ghi xuống NVS một lần.
+ * @return true nếu đã có WiFi
+ */
+bool loadIdentity() {
+  memset(&identity, 0, sizeof(identity));
+  bool empty = true;
+  Preferences prefs;
+  // Namespace chưa tồn tại thì begin() chỉ đọc trả false
+  if (prefs.begin(PROV_NVS_NAMESPACE, true)) {
+    empty = !prefs.isKey("ssid") && !prefs.isKey("id");
+    prefs.getString("ssid", identity.ssid, sizeof(identity.ssid));
+    prefs.getString("pass", identity.password, sizeof(identity.password));
+    prefs.getString("broker", identity.broker, sizeof(identity.broker));
+    prefs.getString("id", identity.deviceId, sizeof(identity.deviceId));
+    identity.port = prefs.getUShort("port", DEFAULT_MQTT_PORT);
+    prefs.end();
+  }
+  bool seed = empty && PROVISION_SSID[0] != '\0';
+  if (seed) {
+    strncpy(identity.ssid, PROVISION_SSID, sizeof(identity.ssid) - 1);
+    strncpy(identity.password, PROVISION_PASSWORD, sizeof(identity.password) - 1);
+    strncpy(identity.deviceId, PROVISION_DEVICE_ID, sizeof(identity.deviceId) - 1);
+  }
+  if (identity.broker[0] == '\0') {
+    strncpy(identity.broker, DEFAULT_MQTT_BROKER, sizeof(identity.broker) - 1);
+  }
+  if (identity.port == 0) {
+    identity.port = DEFAULT_MQTT_PORT;
+  }
+  if (identity.deviceId[0] == '\0') {
+    defaultDeviceId(identity.deviceId, sizeof(identity.deviceId));
+  }
+  if (seed) {
+    Serial.println("🌱 NVS empty, provisioning seeded from build defaults");
+    saveIdentity();
+  }
+
+  Serial.print("🪪 Device: ");
+  Serial.print(identity.deviceId);
+  Serial.print(" | board: ");
+  Serial.println(Board::NAME);
+  if (!isProvisioned()) {
+    Serial.println("⚠️  Not provisioned: send {\"ssid\":..,\"password\":..} over Serial");
+  }
+  return isProvisioned();
+}
+
+/**
+ * Ghi thông tin thiết bị hiện tại xuống NVS
+ */
+bool saveIdentity() {
+  Preferences prefs;
+  if (!prefs.begin(PROV_NVS_NAMESPACE, false)) {
+    Serial.println("❌ Provisioning: cannot open NVS");
+    return false;
+  }
+  prefs.putString("ssid", identity.ssid);
+  prefs.putString("pass", identity.password);
+  prefs.putString("broker", identity.broker);
+  prefs.putUShort("port", identity.port);
+  prefs.putString("id", identity.deviceId);
+  prefs.end();
+  Serial.println("💾 Provisioning saved to NVS");
+  return true;
+}
+
+/**
+ * Copy field chuỗi từ JSON nếu có và vừa buffer
+ * @return false nếu field có nhưng sai kiểu/quá dài
+ */
+bool readProvisionField(JSONVar& doc, const char* key, char* out, size_t size) {
+  if (!doc.hasOwnProperty(key)) {
+    return true;
+  }
+  if (JSON.typeof(doc[key]) != "string") {
+    return false;
+  }
+  const char* value = (const char*)doc[key];
+  if (strlen(value) >= size) {
+    return false;
+  }
+  strcpy(out, value);
+  return true;
+}
+
+/**
+ * Xử lý một dòng provisioning
+ */
+void applyProvisionLine(const char* line) {
+  JSONVar doc = JSON.parse(line);
+  if (JSON.typeof(doc) != "object") {
+    Serial.println("❌ Provisioning: invalid JSON");
+    return;
+  }
+
+  if (doc.hasOwnProperty("reset") && (bool)doc["reset"]) {
+    Preferences prefs;
+    if (prefs.begin(PROV_NVS_NAMESPACE, false)) {
+      prefs.clear();
+      prefs.end();
+    }
+    Serial.println("🗑️  Provisioning cleared, restarting...");
+    ESP.restart();
+    return;
+  }
+
+  DeviceIdentity next = identity;
+  bool ok = readProvisionField(doc, "ssid", next.ssid, sizeof(next.ssid)) &&
+            readProvisionField(doc, "password", next.password, sizeof(next.password)) &&
+            readProvisionField(doc, "broker", next.broker, sizeof(next.broker)) &&
+            readProvisionField(doc, "deviceId", next.deviceId, sizeof(next.deviceId));
+  if (ok && doc.hasOwnProperty("port")) {
+    int port = (int)doc["port"];
+    ok = JSON.typeof(doc["port"]) == "number" && port > 0 && port <= 65535;
+    next.port = (uint16_t)port;
+  }
+  if (!ok) {
+    Serial.println("❌ Provisioning: invalid field");
+    return;
+  }
+
+  identity = next;
+  if (saveIdentity()) {
+    Serial.println("🔄 Restarting with new identity...");
+    ESP.restart();
+  }
+}
+
+/**
+ * Đọc Serial không chặn, gọi trong loop(). Một dòng bắt đầu bằng '{' là lệnh
+ * provisioning, các dòng khác bị bỏ qua.
+ */
+void pollProvisioning() {
+  static char line[PROVISION_LINE_MAX];
+  static size_t length = 0;
+  static bool overflow = false;
+
+  while (Serial.available() > 0) {
+    int c = Serial.read();
+    if (c < 0) {
+      break;
+    }
+    if (c == '\n' || c == '\r') {
+      if (length > 0 && !overflow && line[0] == '{') {
+        line[length] = '\0';
+        applyProvisionLine(line);
+      }
+      length = 0;
+      overflow = false;
+    } else if (length < sizeof(line) - 1) {
+      line[length++] = (char)c;
+    } else {
+      overflow = true;
+    }
+  }
+}
+
+#endif
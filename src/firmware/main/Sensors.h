@@ -1,29 +1,182 @@
+#ifndef SENSORS_H
+#define SENSORS_H
+
 #include "Config.h"
+#include <DHT.h>
+
+// --- CẢM BIẾN NHIỆT/ẨM ---
+// Chọn driver theo Board::HAS_DHT lúc biên dịch: board không có DHT dùng bản
+// rỗng, code thư viện DHT không được link vào binary.
+template <bool Present>
+class ClimateSensor {
+ public:
+  void begin() {}
+  float readTemperature() { return 0; }
+  float readHumidity() { return 0; }
+};
+
+template <>
+class ClimateSensor<true> {
+ public:
+  ClimateSensor() : dht(Board::PIN_DHT, Board::DHT_TYPE) {}
+  void begin() { dht.begin(); }
+  float readTemperature() { return dht.readTemperature(); }
+  float readHumidity() { return dht.readHumidity(); }
+
+ private:
+  DHT dht;
+};
+
+// --- SỰ KIỆN CẢM BIẾN (ISR -> loop) ---
+// Cảm biến mưa dùng ngắt GPIO thay vì đọc liên tục trong loop().
+// ISR chỉ đẩy sự kiện vào queue, loop() chờ queue thay cho delay(100)
+// nên phản ứng ngay khi có mưa/tạnh.
+enum SensorEventType : uint8_t {
+  SENSOR_EVENT_RAIN = 1,
+};
+
+struct SensorEvent {
+  uint8_t type;
+  bool raining;
+  unsigned long isrMicros;  // micros() lúc xảy ra ngắt (để đo độ trễ tới relay)
+};
+
+// Trạng thái mưa đã lọc dội + thống kê thời gian ở mỗi trạng thái
+struct RainState {
+  bool raining;
+  unsigned long since;         // millis() lúc vào trạng thái hiện tại
+  unsigned long rainMsTotal;   // Tổng thời gian mưa (ms), chưa tính trạng thái hiện tại
+  unsigned long dryMsTotal;    // Tổng thời gian khô (ms), chưa tính trạng thái hiện tại
+  bool settlePending;          // Cần kiểm tra lại mức sau cửa sổ debounce
+};
+
+QueueHandle_t sensorEventQueue = NULL;
+volatile unsigned long rainLastEdgeMicros = 0;     // Cạnh được nhận gần nhất (mở cửa sổ debounce)
+volatile unsigned long rainLastRawEdgeMicros = 0;  // Cạnh bất kỳ gần nhất, kể cả cạnh dội bị bỏ qua
+RainState rainState;
+
+// --- HÀM ĐỌC CẢM BIẾN MƯA ---
+// Trả về: true = CO MUA, false = KHONG MUA
+bool readRainStatus() {
+  if (!Board::HAS_RAIN) {
+    return false;
+  }
+  int rainVal = digitalRead(Board::PIN_RAIN);
+  return rainVal == 0;
+  // Cảm biến mưa thường trả về 0 (LOW) khi có nước
+}
 
-// Khởi tạo đối tượng DHT
+// --- NGẮT CẢM BIẾN MƯA ---
+// Debounce cạnh đầu: nhận cạnh đầu tiên ngay, bỏ qua các cạnh dội trong RAIN_DEBOUNCE_MS
+void IRAM_ATTR onRainEdge() {
+  unsigned long now = micros();
+  rainLastRawEdgeMicros = now;  // Mức sau cùng của chuỗi dội đổi tại cạnh này
+  if (now - rainLastEdgeMicros < RAIN_DEBOUNCE_MS * 1000UL) {
+    return;
+  }
+  rainLastEdgeMicros = now;
 
+  SensorEvent event;
+  event.type = SENSOR_EVENT_RAIN;
+  event.raining = (digitalRead(Board::PIN_RAIN) == LOW);
+  event.isrMicros = now;
+
+  BaseType_t woken = pdFALSE;
+  xQueueSendFromISR(sensorEventQueue, &event, &woken);
+  if (woken) {
+    portYIELD_FROM_ISR();
+  }
+}
 
 // --- HÀM KHỞI TẠO CẢM BIẾN ---
 void initSensors() {
-  pinMode(PIN_SOIL, INPUT);
-  pinMode(PIN_RAIN, INPUT);
-  pinMode(PIN_MIC, INPUT);
+  for (int z = 0; z < ZONE_COUNT; z++) {
+    pinMode(zoneSoilPin(z), INPUT);   // Vùng 0 = Board::PIN_SOIL
+  }
+  if (Board::HAS_RAIN) pinMode(Board::PIN_RAIN, INPUT);
+  if (Board::HAS_MIC) pinMode(Board::PIN_MIC, INPUT);
+
+  rainState.raining = readRainStatus();
+  rainState.since = millis();
+  rainState.rainMsTotal = 0;
+  rainState.dryMsTotal = 0;
+  rainState.settlePending = false;
+
+  if (sensorEventQueue == NULL) {
+    sensorEventQueue = xQueueCreate(8, sizeof(SensorEvent));
+  }
+  if (Board::HAS_RAIN) {
+    attachInterrupt(digitalPinToInterrupt(Board::PIN_RAIN), onRainEdge, CHANGE);
+  }
 }
 
 // --- HÀM ĐỌC ĐỘ ẨM ĐẤT (%) ---
-int readSoilMoisture() {
-  int raw = analogRead(PIN_SOIL);
-  // Map ngược: Khô (4095) -> 0%, Ướt (1800) -> 100%
-  int percent = map(raw, SOIL_AIR_VALUE, SOIL_WATER_VALUE, 0, 100);
+// Mỗi vùng một cảm biến, cùng hiệu chỉnh của board
+int readSoilMoisture(int zone = 0) {
+  if (!Board::HAS_SOIL || zone >= ZONE_COUNT) {
+    return 0;
+  }
+  int raw = analogRead(zoneSoilPin(zone));
+  // Map ngược: Khô (SOIL_AIR_VALUE) -> 0%, Ướt (SOIL_WATER_VALUE) -> 100%
+  int percent = map(raw, Board::SOIL_AIR_VALUE, Board::SOIL_WATER_VALUE, 0, 100);
   return constrain(percent, 0, 100);
 }
 
-// --- HÀM ĐỌC CẢM BIẾN MƯA ---
-// Trả về: "CO MUA" hoặc "KHONG MUA"
-bool readRainStatus() {
-  int rainVal = digitalRead(PIN_RAIN);
-  return rainVal == 0;
-  // Cảm biến mưa thường trả về 0 (LOW) khi có nước
+// Đọc độ ẩm đất tất cả vùng vào out[0..ZONE_COUNT-1]
+void readSoilMoistureZones(int* out) {
+  for (int z = 0; z < ZONE_COUNT; z++) {
+    out[z] = readSoilMoisture(z);
+  }
+}
+
+/**
+ * Chờ sự kiện cảm biến tối đa timeoutMs (thay cho delay() cuối loop)
+ * Sau mỗi cạnh được nhận, kiểm tra lại mức chân một lần khi hết cửa sổ debounce:
+ * nếu tín hiệu dội kết thúc ở mức ngược lại thì sinh sự kiện sửa sai, mang thời điểm
+ * cạnh cuối cùng từ ISR (độ trễ irq->relay tính cả thời gian chờ debounce).
+ * @return true nếu có sự kiện (ghi vào event)
+ */
+bool waitSensorEvent(SensorEvent& event, unsigned long timeoutMs) {
+  if (rainState.settlePending) {
+    unsigned long sinceEdge = (micros() - rainLastEdgeMicros) / 1000UL;
+    if (sinceEdge >= RAIN_DEBOUNCE_MS) {
+      rainState.settlePending = false;
+      bool raining = readRainStatus();
+      if (raining != rainState.raining) {
+        event.type = SENSOR_EVENT_RAIN;
+        event.raining = raining;
+        event.isrMicros = rainLastRawEdgeMicros;
+        return true;
+      }
+    } else {
+      timeoutMs = min(timeoutMs, RAIN_DEBOUNCE_MS - sinceEdge);
+    }
+  }
+  return xQueueReceive(sensorEventQueue, &event, pdMS_TO_TICKS(timeoutMs)) == pdTRUE;
+}
+
+/**
+ * Cập nhật trạng thái mưa từ sự kiện, cộng dồn thời gian ở trạng thái cũ
+ * @param previousStateMs Thời gian ở trạng thái trước (ms)
+ * @return true nếu trạng thái thực sự thay đổi
+ */
+bool applyRainEvent(const SensorEvent& event, unsigned long& previousStateMs) {
+  rainState.settlePending = true;
+  if (event.raining == rainState.raining) {
+    return false;
+  }
+  unsigned long now = millis();
+  previousStateMs = now - rainState.since;
+  if (rainState.raining) {
+    rainState.rainMsTotal += previousStateMs;
+  } else {
+    rainState.dryMsTotal += previousStateMs;
+  }
+  rainState.raining = event.raining;
+  rainState.since = now;
+  return true;
 }
 
 // --- HÀM IN THÔNG TIN TỔNG HỢP ---
+
+#endif
@@ -8,30 +8,50 @@
 
 #include <WiFi.h>
 #include "Config.h"
+#include "Provisioning.h"
+
+unsigned long wifiBeginAt = 0;    // millis() lần gọi WiFi.begin() gần nhất
+bool wifiWasConnected = false;
 
 /**
- * Kết nối WiFi
+ * Bắt đầu kết nối WiFi, không chờ: loop() vẫn chạy (điều khiển, sự kiện mưa)
+ * trong lúc WiFi lên. Trạng thái được theo dõi bởi wifiReady().
  */
 void setupWiFi() {
+  if (!isProvisioned()) {
+    return;  // Chưa có SSID trong NVS, chờ provisioning qua Serial
+  }
   WiFi.mode(WIFI_STA);
-  WiFi.begin(ssid, password);
-  
-  Serial.print("📡 Connecting to WiFi");
-  int attempts = 0;
-  while (WiFi.status() != WL_CONNECTED && attempts < 20) {
-    delay(500);
-    Serial.print(".");
-    attempts++;
+  WiFi.setAutoReconnect(true);
+  WiFi.begin(identity.ssid, identity.password);
+  wifiBeginAt = millis();
+  Serial.println("📡 Connecting to WiFi...");
+}
+
+/**
+ * Kiểm tra WiFi (không chặn), log khi trạng thái đổi. Mất WiFi quá
+ * WIFI_RETRY_INTERVAL thì gọi lại WiFi.begin() (vd AP chưa bật lúc boot).
+ * @return true nếu WiFi đã kết nối
+ */
+bool wifiReady() {
+  bool connected = WiFi.status() == WL_CONNECTED;
+  if (connected != wifiWasConnected) {
+    wifiWasConnected = connected;
+    if (connected) {
+      Serial.print("✅ WiFi connected. IP: ");
+      Serial.println(WiFi.localIP());
+    } else {
+      Serial.println("❌ WiFi connection lost");
+      wifiBeginAt = millis();
+    }
   }
-  
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.println();
-    Serial.print("✅ WiFi connected. IP: ");
-    Serial.println(WiFi.localIP());
-  } else {
-    Serial.println();
-    Serial.println("❌ WiFi connection failed!");
+  if (!connected && isProvisioned() && millis() - wifiBeginAt >= WIFI_RETRY_INTERVAL) {
+    Serial.println("📡 WiFi still down, retrying...");
+    WiFi.disconnect();
+    WiFi.begin(identity.ssid, identity.password);
+    wifiBeginAt = millis();
   }
+  return connected;
 }
 
 #endif
@@ -1,40 +1,43 @@
 #include <Arduino.h>
 #include "Config.h"
+#include "Provisioning.h"
 #include "Sensors.h"
 #include "WiFiModule.h"
+#include "Actuators.h"
+#include "DeviceConfig.h"
+#include "Diagnostics.h"
 #include "MQTT.h"
 #include "MQTTHandlers.h"
 #include "Control.h"
-#include <DHT.h>
 
 // ===== Biến toàn cục =====
 int temperature;
 int humidity;
+bool climateValid = false;   // Đã có lần đọc DHT hợp lệ
 bool isRain;
-int soilMoisture;
-DHT dht(PIN_DHT, DHTTYPE);
+int soilMoisture[MAX_ZONES];   // Độ ẩm đất từng vùng (%)
+ClimateSensor<Board::HAS_DHT> dht;
 
-// Khai báo extern để truy cập deviceMode từ Config.h
-extern String deviceMode;
+void handleSensorEvent(const SensorEvent& event);
+void pollSensorEvents();
+void readClimate();
+
+// Thời điểm (ms từ lúc boot) logic điều khiển chạy lần đầu với config đã nạp
+unsigned long bootToControlMs = 0;
 
 // ===== MQTT Client =====
 WiFiClient espClient;
 PubSubClient mqttClient(espClient);
 
 // ===== MQTT Topics =====
-String topicSensorData;
-String topicStatus;
-String topicPumpStatus;
-String topicCommand;
-String topicConfig;
-String topicFirmware;
+DeviceTopics topics;
 
 // ===== Timing =====
 unsigned long lastSensorPublish = 0;
   // Gửi dữ liệu mỗi 5 giây
 
 unsigned long lastHeartbeat = 0;
- // Heartbeat mỗi 30 giây
+ // Diagnostics mỗi 30 giây (heartbeatInterval)
 
 unsigned long lastLoop = 0;
 
@@ -43,60 +46,147 @@ void setup() {
   Serial.begin(115200);
   delay(1000);
   
+  // Nạp WiFi/broker/deviceId từ NVS, cấu hình MQTT theo identity (chưa kết nối)
+  loadIdentity();
+  setupMQTT();
+  
   // Khởi tạo sensors
   dht.begin();
   initSensors();
   
-  // Khởi tạo relay
-  pinMode(PIN_RELAY_1, OUTPUT);
-  digitalWrite(PIN_RELAY_1, HIGH);
+  // Khởi tạo tất cả relay (actuatorDef() - Config.h)
+  initActuators();
+  
+  // Nạp config từ NVS (mode, ngưỡng, chu kỳ) - không cần đợi Backend
+  loadDeviceConfig();
+  
+  // Chạy logic điều khiển ngay với config đã nạp, trước khi kết nối mạng
+  readClimate();
+  isRain = rainState.raining;
+  readSoilMoistureZones(soilMoisture);
+  controlZones(soilMoisture, temperature, humidity, climateValid, isRain, deviceConfig);
+  lastLoop = millis();
+  bootToControlMs = lastLoop;
+  Serial.print("⏱️  Boot to control: ");
+  Serial.print(bootToControlMs);
+  Serial.print(" ms (mode: ");
+  Serial.print(modeToString(deviceConfig.mode));
+  Serial.print(", zones: ");
+  Serial.print(ZONE_COUNT);
+  Serial.println(")");
   
   Serial.println("🚀 ESP32 Starting...");
   
   // Kết nối WiFi
   setupWiFi();
   
-  // Đợi WiFi kết nối trước khi setup MQTT
-  if (WiFi.status() == WL_CONNECTED) {
-    // Kết nối MQTT
-    setupMQTT();
-    Serial.println("Setup complete!");
-  } else {
-    Serial.println("Setup incomplete - WiFi not connected. MQTT will retry in loop().");
+  // WiFi kết nối nền; loop() thử MQTT khi WiFi lên (không block setup)
+  if (isProvisioned()) {
+    reconnectMQTT();
   }
+  Serial.println("Setup complete!");
 }
 
 void loop() {
+  // Nhận provisioning qua Serial (không chặn)
+  pollProvisioning();
+  
   // Duy trì kết nối MQTT
-  if (!mqttClient.connected()) {
+  if (isProvisioned() && !mqttClient.connected()) {
     reconnectMQTT();
   }
   mqttClient.loop();
   
-  // Đọc dữ liệu sensor
-  temperature = dht.readTemperature();
-  humidity = dht.readHumidity();
-  isRain = readRainStatus();
-  soilMoisture = readSoilMoisture();
+  // Tự tắt các kênh hết thời gian xung
+  if (updateActuators()) {
+    publishPumpStatus();
+  }
+  
+  // Đọc dữ liệu sensor (mưa cập nhật qua ngắt, xem handleSensorEvent)
+  readClimate();
+  isRain = rainState.raining;
+  readSoilMoistureZones(soilMoisture);
   
-  // Logic điều khiển bơm (chỉ chạy khi mode = "auto")
-  if (millis() - lastLoop >= LOOP_INTERVAL) {
-    controlPump(soilMoisture, temperature, humidity, isRain, deviceMode);
+  // Logic điều khiển bơm từng vùng (chỉ chạy cho vùng có mode = auto)
+  if (millis() - lastLoop >= deviceConfig.loopInterval) {
+    controlZones(soilMoisture, temperature, humidity, climateValid, isRain, deviceConfig);
     publishPumpStatus();
     lastLoop = millis();
   }
   
-  // Gửi dữ liệu sensor qua MQTT định kỳ
-  if (millis() - lastSensorPublish >= SENSOR_PUBLISH_INTERVAL) {
+  // Gửi dữ liệu sensor qua MQTT định kỳ (một message cho tất cả vùng)
+  if (millis() - lastSensorPublish >= deviceConfig.sensorPublishInterval) {
     publishSensorData(temperature, humidity, soilMoisture, isRain);
     lastSensorPublish = millis();
   }
   
-  // Gửi heartbeat
-  // if (millis() - lastHeartbeat >= HEARTBEAT_INTERVAL) {
-  //   publishHeartbeat();
-  //   lastHeartbeat = millis();
-  // }
+  // Gửi số liệu chẩn đoán
+  if (millis() - lastHeartbeat >= deviceConfig.heartbeatInterval) {
+    publishDiagnostics();
+    lastHeartbeat = millis();
+  }
+  
+  // Chờ sự kiện cảm biến thay cho delay(100): mưa/tạnh được xử lý ngay
+  SensorEvent event;
+  if (waitSensorEvent(event, 100)) {
+    handleSensorEvent(event);
+  }
+}
+
+/**
+ * Đọc nhiệt độ/độ ẩm. DHT trả NaN khi chưa sẵn sàng (ngay sau begin(), lần điều khiển
+ * lúc boot) hoặc đọc lỗi: giữ giá trị hợp lệ gần nhất, chưa có thì climateValid = false
+ * để logic điều khiển bỏ qua nhánh nóng/khô.
+ */
+void readClimate() {
+  float t = dht.readTemperature();
+  float h = dht.readHumidity();
+  if (isnan(t) || isnan(h)) {
+    return;
+  }
+  temperature = (int)t;
+  humidity = (int)h;
+  climateValid = true;
+}
+
+/**
+ * Xử lý các sự kiện cảm biến đang chờ mà không block. Gọi từ những vòng chờ dài
+ * ngoài loop() (tải OTA) để mưa vẫn tắt bơm ngay.
+ */
+void pollSensorEvents() {
+  SensorEvent event;
+  while (waitSensorEvent(event, 0)) {
+    handleSensorEvent(event);
+  }
+}
+
+/**
+ * Xử lý sự kiện từ ISR: đánh giá lại logic bơm ngay, không đợi LOOP_INTERVAL
+ */
+void handleSensorEvent(const SensorEvent& event) {
+  if (event.type != SENSOR_EVENT_RAIN) {
+    return;
+  }
+  
+  unsigned long previousStateMs = 0;
+  if (!applyRainEvent(event, previousStateMs)) {
+    return;
+  }
+  isRain = rainState.raining;
+  
+  controlZones(soilMoisture, temperature, humidity, climateValid, isRain, deviceConfig);
+  unsigned long latencyUs = micros() - event.isrMicros;
+  recordIrqToRelay(latencyUs);
+  
+  Serial.print(isRain ? "🌧️  Rain started" : "☀️  Rain stopped");
+  Serial.print(" (previous state ");
+  Serial.print(previousStateMs);
+  Serial.print(" ms, irq->relay ");
+  Serial.print(latencyUs);
+  Serial.println(" us)");
   
-  delay(100);
+  publishRainEvent(previousStateMs, latencyUs);
+  publishSensorData(temperature, humidity, soilMoisture, isRain);
+  publishPumpStatus();
+  lastSensorPublish = millis();
 }
\ No newline at end of file
@@ -0,0 +1,170 @@
+/**
+ * Firmware Host Adapter - cài đặt
+ * File duy nhất include firmware: Config.h định nghĩa biến toàn cục không inline.
+ */
+
+#include "Firmware.h"
+
+#include <utility>
+
+#include "../main/main.ino"
+
+struct FirmwareContext {
+  std::string id;
+
+  // Biến toàn cục của firmware (main.ino, Actuators.h, DeviceConfig.h)
+  ActuatorState actuators[ACTUATOR_COUNT] = {};
+  esp_timer_handle_t actuatorTimers[ACTUATOR_COUNT] = {};
+  unsigned long pulseEnded = 0;
+  DeviceConfig config = {};
+  unsigned long configLoad = 0;
+  unsigned long bootToControl = 0;
+  int temperature = 0;
+  int humidity = 0;
+  bool climateValid = false;
+  bool isRain = false;
+  int soilMoisture[MAX_ZONES] = {};
+  unsigned long lastSensorPublish = 0;
+  unsigned long lastHeartbeat = 0;
+  unsigned long lastLoop = 0;
+  unsigned long lastMqttAttempt = 0;
+  bool mqttAttempted = false;
+  unsigned long wifiBeginAt = 0;
+  bool wifiWasConnected = false;
+  QueueHandle_t sensorQueue = NULL;
+  unsigned long rainLastEdge = 0;
+  unsigned long rainLastRawEdge = 0;
+  RainState rain = {};
+  DiagnosticsMetrics diagnostics = {};
+  DeviceIdentity identity = {};
+  DeviceTopics topics = {};
+};
+
+static FirmwareContext* active = nullptr;
+
+FirmwareContext* fwCreate(const std::string& deviceId) {
+  FirmwareContext* ctx = new FirmwareContext();
+  ctx->id = deviceId;
+  setDefaultConfig(ctx->config);
+  return ctx;
+}
+
+void fwDestroy(FirmwareContext* ctx) {
+  delete ctx;
+}
+
+// Hoán đổi trạng thái giữa context và biến toàn cục
+static void swapState(FirmwareContext* ctx) {
+  std::swap(ctx->identity, identity);
+  std::swap(ctx->topics, topics);
+  for (int i = 0; i < ACTUATOR_COUNT; i++) {
+    std::swap(ctx->actuators[i], actuatorStates[i]);
+    std::swap(ctx->actuatorTimers[i], actuatorTimers[i]);
+  }
+  unsigned long ended = actuatorPulseEnded;
+  actuatorPulseEnded = ctx->pulseEnded;
+  ctx->pulseEnded = ended;
+  std::swap(ctx->config, deviceConfig);
+  std::swap(ctx->configLoad, configLoadMicros);
+  std::swap(ctx->bootToControl, bootToControlMs);
+  std::swap(ctx->temperature, temperature);
+  std::swap(ctx->humidity, humidity);
+  std::swap(ctx->climateValid, climateValid);
+  std::swap(ctx->isRain, isRain);
+  for (int z = 0; z < MAX_ZONES; z++) {
+    std::swap(ctx->soilMoisture[z], soilMoisture[z]);
+  }
+  std::swap(ctx->lastSensorPublish, lastSensorPublish);
+  std::swap(ctx->lastHeartbeat, lastHeartbeat);
+  std::swap(ctx->lastLoop, lastLoop);
+  std::swap(ctx->lastMqttAttempt, lastMqttAttempt);
+  std::swap(ctx->mqttAttempted, mqttAttempted);
+  std::swap(ctx->wifiBeginAt, wifiBeginAt);
+  std::swap(ctx->wifiWasConnected, wifiWasConnected);
+  std::swap(ctx->sensorQueue, sensorEventQueue);
+  unsigned long edge = rainLastEdgeMicros;
+  rainLastEdgeMicros = ctx->rainLastEdge;
+  ctx->rainLastEdge = edge;
+  edge = rainLastRawEdgeMicros;
+  rainLastRawEdgeMicros = ctx->rainLastRawEdge;
+  ctx->rainLastRawEdge = edge;
+  std::swap(ctx->rain, rainState);
+  std::swap(ctx->diagnostics, ::diagnostics);
+}
+
+void fwEnter(FirmwareContext* ctx) {
+  swapState(ctx);
+  active = ctx;
+}
+
+void fwLeave(FirmwareContext* ctx) {
+  swapState(ctx);
+  active = nullptr;
+}
+
+void fwSetup() {
+  // Provisioning như thiết bị thật: WiFi + deviceId nằm trong NVS trước lần boot đầu.
+  // Broker không dùng tới - simulator tự mở kết nối tới --host/--port.
+  Preferences prefs;
+  if (prefs.begin(PROV_NVS_NAMESPACE, false)) {
+    if (!prefs.isKey("id")) {
+      prefs.putString("ssid", "sim");
+      prefs.putString("id", active->id.c_str());
+    }
+    prefs.end();
+  }
+  setup();
+}
+
+void fwLoop() {
+  simRunTimers();  // Xung relay hết giờ (task esp_timer trên thiết bị thật)
+  loop();
+}
+
+void fwDeliver(const std::string& topic, const std::string& payload) {
+  std::string topicCopy = topic;
+  mqttCallback(&topicCopy[0], (byte*)payload.data(), payload.size());
+}
+
+void fwConfigure(const std::string& configJson) {
+  handleConfig(String(configJson));
+}
+
+void fwExpireTimers() {
+  unsigned long past = millis() - 0x40000000UL;
+  lastLoop = past;
+  lastSensorPublish = past;
+  lastHeartbeat = past;
+}
+
+unsigned long fwRainEvents(unsigned long& lastIrqToRelayUs) {
+  lastIrqToRelayUs = ::diagnostics.lastIrqToRelayUs;
+  return ::diagnostics.rainEvents;
+}
+
+void fwSimulateEnvironment(SimHardware& hw, double rainToggleProbability) {
+  // Đất mỗi vùng khô dần (ADC tăng) khi bơm vùng tắt, ẩm lên khi bơm bật
+  for (int z = 0; z < ZONE_COUNT; z++) {
+    int& soil = hw.analog[zoneSoilPin(z)];
+    if (soil == 0) {
+      soil = random(Board::SOIL_WATER_VALUE, Board::SOIL_AIR_VALUE);
+      hw.pins[Board::PIN_RAIN] = HIGH;
+    }
+    soil += isActuatorOn(zoneActuator(z)) ? -40 : 8;
+    soil += random(-10, 11);
+    soil = constrain(soil, Board::SOIL_WATER_VALUE, Board::SOIL_AIR_VALUE);
+  }
+
+  hw.temperature = constrain(hw.temperature + random(-1, 2) * 0.1f, 20.0f, 40.0f);
+  hw.humidity = constrain(hw.humidity + random(-1, 2) * 0.2f, 20.0f, 95.0f);
+
+  // Cảm biến mưa: LOW = có mưa. Đổi trạng thái kèm vài cạnh dội như tiếp điểm thật
+  if (rand() < rainToggleProbability * RAND_MAX) {
+    int level = hw.pins[Board::PIN_RAIN] == LOW ? HIGH : LOW;
+    for (int bounce = random(4); bounce > 0; bounce--) {
+      simSetInput(Board::PIN_RAIN, level);
+      simSetInput(Board::PIN_RAIN, level == LOW ? HIGH : LOW);
+    }
+    simSetInput(Board::PIN_RAIN, level);
+  }
+}
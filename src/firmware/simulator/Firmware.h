@@ -0,0 +1,37 @@
+/**
+ * Firmware Host Adapter
+ * Biên dịch nguyên main/main.ino (setup/loop, MQTT.h, MQTTHandlers.h, Control.h...)
+ * trên Linux với các shim trong shim/. Firmware dùng biến toàn cục, nên mỗi thiết bị
+ * ảo giữ một FirmwareContext và được "nạp" vào biến toàn cục trước mỗi lần gọi.
+ */
+
+#ifndef FIRMWARE_H
+#define FIRMWARE_H
+
+#include <string>
+#include "shim/SimHooks.h"
+
+struct FirmwareContext;
+
+FirmwareContext* fwCreate(const std::string& deviceId);
+void fwDestroy(FirmwareContext* ctx);
+
+// Nạp/lưu trạng thái thiết bị vào biến toàn cục firmware. Mọi hàm fw* bên dưới
+// phải được gọi giữa fwEnter() và fwLeave().
+void fwEnter(FirmwareContext* ctx);
+void fwLeave(FirmwareContext* ctx);
+
+void fwSetup();                                      // setup() của firmware
+void fwLoop();                                       // Một vòng loop() (không có delay(100))
+void fwDeliver(const std::string& topic, const std::string& payload);  // mqttCallback()
+void fwConfigure(const std::string& configJson);     // handleConfig()
+void fwExpireTimers();                               // loop() kế tiếp chạy điều khiển + publish ngay
+
+// Số sự kiện mưa đã xử lý và độ trễ ngắt -> relay của lần gần nhất (Diagnostics.h)
+unsigned long fwRainEvents(unsigned long& lastIrqToRelayUs);
+
+// Sinh dữ liệu cảm biến giả (random walk) vào phần cứng ảo (gọi sau fwEnter).
+// Cảm biến mưa đổi trạng thái với xác suất rainToggleProbability mỗi lần gọi, qua ISR.
+void fwSimulateEnvironment(SimHardware& hw, double rainToggleProbability);
+
+#endif
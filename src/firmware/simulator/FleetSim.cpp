@@ -0,0 +1,711 @@
+/**
+ * Fleet Simulator
+ * Chạy hàng nghìn thiết bị ảo (mỗi thiết bị chạy nguyên setup()/loop() của firmware)
+ * trên một event loop epoll, kết nối tới broker MQTT thật để load-test Backend.
+ *
+ * Đo:
+ *  - Thông lượng broker -> backend: client "monitor" subscribe các topic mà
+ *    mqttService.js nhận (sensor/data, status, heartbeat) và đếm message/byte
+ *  - Command round-trip: monitor gửi relay2_on/off, đo tới khi heartbeat của
+ *    thiết bị báo đúng trạng thái relay mới
+ *  - Độ trễ ngắt mưa -> relay: cảm biến mưa ảo đổi mức (kèm dội) qua ISR của
+ *    firmware, lấy số liệu từ Diagnostics.h sau mỗi lần loop()
+ */
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Firmware.h"
+#include "MqttConnection.h"
+#include "shim/Arduino.h"
+
+namespace {
+
+// ===== Tùy chọn dòng lệnh =====
+struct Options {
+  std::string host = "127.0.0.1";
+  int port = 1883;
+  int devices = 100;
+  std::string idPrefix = "SIM_";
+  int rampPerSec = 200;           // Số thiết bị khởi động mỗi giây
+  int durationSec = 60;
+  int loopMs = 100;               // delay(100) cuối loop() của firmware
+  int heartbeatMs = 0;            // 0 = mặc định firmware (LOOP_INTERVAL)
+  int sensorMs = 0;               // 0 = mặc định firmware (SENSOR_PUBLISH_INTERVAL)
+  double dropRate = 0;            // Xác suất mỗi thiết bị bị rớt kết nối mỗi giây
+  int stormEverySec = 0;          // Chu kỳ ngắt đồng loạt mọi kết nối (0 = tắt)
+  int wifiOutageMs = 0;           // Thời gian mất WiFi sau mỗi storm
+  double commandRate = 1;         // Lệnh/giây từ monitor
+  int otaEverySec = 0;            // Chu kỳ gửi firmware/update (0 = tắt)
+  double rainPerMinute = 0.2;     // Số lần mưa/tạnh mỗi thiết bị mỗi phút
+  int reportSec = 5;
+  bool verbose = false;
+};
+
+// ===== Thiết bị ảo =====
+struct VirtualDevice {
+  std::string id;
+  SimHardware hw;
+  FirmwareContext* fw = nullptr;
+  MqttConnection mqtt;
+  int registeredFd = -1;
+  uint32_t registeredEvents = 0;
+  bool started = false;
+  unsigned long wifiBackAt = 0;
+  uint64_t connectStartUs = 0;
+
+  // Lệnh đang chờ xác nhận qua heartbeat
+  bool relay2Requested = false;   // Trạng thái relay2 của lệnh gần nhất
+  bool commandPending = false;
+  bool commandExpectOn = false;
+  uint64_t commandSentUs = 0;
+};
+
+// ===== Thống kê =====
+struct Histogram {
+  std::vector<uint32_t> samples;  // µs
+
+  void add(uint64_t us) { samples.push_back((uint32_t)std::min<uint64_t>(us, UINT32_MAX)); }
+  void clear() { samples.clear(); }
+  double percentileMs(double p) {
+    if (samples.empty()) return 0;
+    size_t index = std::min(samples.size() - 1, (size_t)(p * samples.size()));
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index] / 1000.0;
+  }
+  double maxMs() const {
+    return samples.empty() ? 0 : *std::max_element(samples.begin(), samples.end()) / 1000.0;
+  }
+};
+
+struct Counters {
+  uint64_t connectAttempts = 0;
+  uint64_t connectFailures = 0;
+  uint64_t connacks = 0;
+  uint64_t disconnects = 0;
+  uint64_t injectedDrops = 0;
+  uint64_t devicePublishes = 0;
+  uint64_t deviceBytes = 0;
+  uint64_t brokerMessages = 0;    // Monitor nhận được (broker -> backend)
+  uint64_t brokerBytes = 0;
+  uint64_t commandsSent = 0;
+  uint64_t commandsConfirmed = 0;
+  uint64_t commandTimeouts = 0;
+  uint64_t otaRequests = 0;
+  uint64_t rainEvents = 0;
+};
+
+Options options;
+std::vector<std::unique_ptr<VirtualDevice>> fleet;
+std::unordered_map<std::string, int> deviceIndex;
+VirtualDevice* current = nullptr;
+SimHardware idleHardware;
+sockaddr_in brokerAddress;
+int epollFd = -1;
+volatile sig_atomic_t stopRequested = 0;
+
+MqttConnection monitor;
+int monitorRegisteredFd = -1;
+uint32_t monitorRegisteredEvents = 0;
+const uint64_t MONITOR_TAG = UINT64_MAX;
+const uint64_t COMMAND_TIMEOUT_US = 10000000;
+
+Counters total;
+Counters window;
+Histogram commandRtt;
+Histogram commandRttTotal;
+Histogram connectLatency;
+Histogram connectLatencyTotal;
+Histogram rainLatency;
+Histogram rainLatencyTotal;
+
+void count(uint64_t Counters::*field, uint64_t amount = 1) {
+  total.*field += amount;
+  window.*field += amount;
+}
+
+uint64_t nowUs() { return micros(); }
+
+// ===== epoll =====
+void syncEpoll(int fd, int& registeredFd, uint32_t& registeredEvents, uint64_t tag, bool wantWrite) {
+  if (fd < 0) {
+    registeredFd = -1;  // close() đã tự gỡ fd khỏi epoll
+    return;
+  }
+  uint32_t events = EPOLLIN | EPOLLRDHUP | (wantWrite ? (uint32_t)EPOLLOUT : 0u);
+  epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.events = events;
+  ev.data.u64 = tag;
+  if (registeredFd != fd) {
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+    registeredFd = fd;
+    registeredEvents = events;
+  } else if (registeredEvents != events) {
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &ev);
+    registeredEvents = events;
+  }
+}
+
+void syncDevice(VirtualDevice& dev, uint64_t tag);
+
+// ===== Chạy firmware trong ngữ cảnh một thiết bị =====
+template <class F>
+void runFirmware(int index, F body) {
+  VirtualDevice& dev = *fleet[index];
+  current = &dev;
+  fwEnter(dev.fw);
+  body();
+  fwLeave(dev.fw);
+  current = nullptr;
+  syncDevice(dev, index);
+}
+
+void handleDeviceClosed(VirtualDevice& dev) {
+  if (dev.mqtt.state() == MqttConnection::CONNECTING) {
+    // Handshake thất bại: firmware thử lại sau MQTT_RETRY_INTERVAL
+    count(&Counters::connectFailures);
+  } else if (dev.mqtt.state() == MqttConnection::CONNECTED) {
+    count(&Counters::disconnects);
+  }
+  dev.mqtt.close();
+  dev.registeredFd = -1;
+}
+
+void syncDevice(VirtualDevice& dev, uint64_t tag) {
+  if (dev.mqtt.fd() >= 0 && !dev.mqtt.flush()) {
+    handleDeviceClosed(dev);
+  }
+  bool wantWrite = dev.mqtt.hasPendingOutput() || dev.mqtt.state() == MqttConnection::CONNECTING;
+  syncEpoll(dev.mqtt.fd(), dev.registeredFd, dev.registeredEvents, tag, wantWrite);
+}
+
+void handleDeviceIo(int index, uint32_t events) {
+  VirtualDevice& dev = *fleet[index];
+  if (dev.mqtt.fd() < 0) {
+    return;
+  }
+
+  if (events & EPOLLOUT) {
+    if (!dev.mqtt.flush()) {
+      handleDeviceClosed(dev);
+      return;
+    }
+  }
+
+  if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+    std::vector<std::pair<std::string, std::string>> inbox;
+    bool wasConnecting = dev.mqtt.state() == MqttConnection::CONNECTING;
+    bool alive = dev.mqtt.receive([&](const std::string& topic, const std::string& payload) {
+      inbox.emplace_back(topic, payload);
+    });
+
+    if (wasConnecting && dev.mqtt.state() == MqttConnection::CONNECTED) {
+      count(&Counters::connacks);
+      connectLatency.add(nowUs() - dev.connectStartUs);
+      connectLatencyTotal.add(nowUs() - dev.connectStartUs);
+    }
+    if (!inbox.empty()) {
+      runFirmware(index, [&] {
+        for (const auto& message : inbox) {
+          fwDeliver(message.first, message.second);
+        }
+      });
+    }
+    if (!alive || (events & (EPOLLHUP | EPOLLERR))) {
+      handleDeviceClosed(dev);
+      return;
+    }
+  }
+  syncDevice(dev, index);
+}
+
+// ===== Monitor (đóng vai Backend) =====
+void monitorConnect() {
+  monitor.open(brokerAddress, "fleet-sim-monitor-" + std::to_string(getpid()), 60);
+  monitor.queueSubscribe("iot/device/+/sensor/data");
+  monitor.queueSubscribe("iot/device/+/status");
+  monitor.queueSubscribe("iot/device/+/heartbeat");
+  syncEpoll(monitor.fd(), monitorRegisteredFd, monitorRegisteredEvents, MONITOR_TAG, true);
+}
+
+void monitorSync() {
+  if (monitor.fd() >= 0 && !monitor.flush()) {
+    monitor.close();
+  }
+  syncEpoll(monitor.fd(), monitorRegisteredFd, monitorRegisteredEvents, MONITOR_TAG,
+            monitor.hasPendingOutput() || monitor.state() == MqttConnection::CONNECTING);
+}
+
+// "iot/device/<id>/heartbeat" -> chỉ số thiết bị, -1 nếu không phải thiết bị ảo
+int deviceFromTopic(const std::string& topic, std::string& suffix) {
+  const std::string prefix = "iot/device/";
+  if (topic.compare(0, prefix.size(), prefix) != 0) return -1;
+  size_t slash = topic.find('/', prefix.size());
+  if (slash == std::string::npos) return -1;
+  auto it = deviceIndex.find(topic.substr(prefix.size(), slash - prefix.size()));
+  if (it == deviceIndex.end()) return -1;
+  suffix = topic.substr(slash + 1);
+  return it->second;
+}
+
+void monitorOnPublish(const std::string& topic, const std::string& payload) {
+  count(&Counters::brokerMessages);
+  count(&Counters::brokerBytes, topic.size() + payload.size());
+
+  std::string suffix;
+  int index = deviceFromTopic(topic, suffix);
+  if (index < 0 || suffix != "heartbeat") return;
+
+  VirtualDevice& dev = *fleet[index];
+  if (!dev.commandPending) return;
+  size_t pos = payload.find("\"relays\":");
+  if (pos == std::string::npos) return;
+  long relays = atol(payload.c_str() + pos + 9);
+  bool relay2On = (relays & 2) != 0;  // Kênh 1 trong ACTUATORS[] = relay2
+  if (relay2On == dev.commandExpectOn) {
+    uint64_t rtt = nowUs() - dev.commandSentUs;
+    commandRtt.add(rtt);
+    commandRttTotal.add(rtt);
+    count(&Counters::commandsConfirmed);
+    dev.commandPending = false;
+  }
+}
+
+void handleMonitorIo(uint32_t events) {
+  if (events & EPOLLOUT) {
+    monitor.flush();
+  }
+  if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+    if (!monitor.receive(monitorOnPublish)) {
+      fprintf(stderr, "❌ Monitor connection lost, reconnecting\n");
+      monitor.close();
+      monitorRegisteredFd = -1;
+      monitorConnect();
+      return;
+    }
+  }
+  monitorSync();
+}
+
+int randomConnectedDevice() {
+  for (int attempt = 0; attempt < 16; attempt++) {
+    int index = rand() % fleet.size();
+    VirtualDevice& dev = *fleet[index];
+    if (dev.mqtt.state() == MqttConnection::CONNECTED && !dev.commandPending) {
+      return index;
+    }
+  }
+  return -1;
+}
+
+void sendCommand() {
+  if (monitor.state() != MqttConnection::CONNECTED) return;
+  int index = randomConnectedDevice();
+  if (index < 0) return;
+
+  VirtualDevice& dev = *fleet[index];
+  dev.relay2Requested = !dev.relay2Requested;  // Luân phiên bật/tắt
+  dev.commandExpectOn = dev.relay2Requested;
+  dev.commandPending = true;
+  dev.commandSentUs = nowUs();
+  monitor.queuePublish("iot/device/" + dev.id + "/command",
+                       dev.commandExpectOn ? "{\"action\":\"relay2_on\"}" : "{\"action\":\"relay2_off\"}");
+  count(&Counters::commandsSent);
+}
+
+void sendOtaCommand() {
+  if (monitor.state() != MqttConnection::CONNECTED) return;
+  int index = randomConnectedDevice();
+  if (index < 0) return;
+  monitor.queuePublish("iot/device/" + fleet[index]->id + "/firmware/update",
+                       "{\"version\":\"sim\",\"firmwareUrl\":\"http://127.0.0.1:9/firmware.bin\","
+                       "\"firmwareSize\":1048576,\"action\":\"start_update\"}");
+}
+
+// ===== Fault injection =====
+void dropDevice(VirtualDevice& dev) {
+  if (dev.mqtt.fd() < 0) return;
+  count(&Counters::injectedDrops);
+  handleDeviceClosed(dev);
+}
+
+void reconnectStorm() {
+  unsigned long now = millis();
+  int dropped = 0;
+  for (auto& dev : fleet) {
+    if (!dev->started) continue;
+    if (dev->mqtt.fd() >= 0) {
+      dropDevice(*dev);
+      dropped++;
+    }
+    if (options.wifiOutageMs > 0) {
+      dev->hw.wifiUp = false;
+      dev->wifiBackAt = now + options.wifiOutageMs + random(options.wifiOutageMs / 5 + 1);
+    }
+  }
+  printf("⚡ Reconnect storm: dropped %d connections\n", dropped);
+}
+
+// ===== Báo cáo =====
+void report(double elapsedSec, double windowSec, bool final) {
+  int online = 0;
+  for (auto& dev : fleet) {
+    if (dev->mqtt.state() == MqttConnection::CONNECTED) online++;
+  }
+  Counters& c = final ? total : window;
+  Histogram& rtt = final ? commandRttTotal : commandRtt;
+  Histogram& rain = final ? rainLatencyTotal : rainLatency;
+  Histogram& connect = final ? connectLatencyTotal : connectLatency;
+  double seconds = final ? elapsedSec : windowSec;
+  if (seconds <= 0) seconds = 1;
+
+  printf("[%6.1fs]%s online %d/%zu | connect %.0f/s (fail %llu, p50 %.1f p99 %.1f ms) | "
+         "dev tx %.0f msg/s | broker->backend %.0f msg/s %.1f KB/s | "
+         "cmd rtt p50 %.2f p95 %.2f p99 %.2f max %.2f ms (n=%llu, timeout %llu) | "
+         "drops %llu disc %llu ota %llu | rain irq->relay p50 %.3f p99 %.3f max %.3f ms (n=%llu)\n",
+         elapsedSec, final ? " TOTAL" : "", online, fleet.size(),
+         c.connectAttempts / seconds, (unsigned long long)c.connectFailures,
+         connect.percentileMs(0.50), connect.percentileMs(0.99),
+         c.devicePublishes / seconds,
+         c.brokerMessages / seconds, c.brokerBytes / seconds / 1024.0,
+         rtt.percentileMs(0.50), rtt.percentileMs(0.95), rtt.percentileMs(0.99), rtt.maxMs(),
+         (unsigned long long)c.commandsConfirmed, (unsigned long long)c.commandTimeouts,
+         (unsigned long long)c.injectedDrops, (unsigned long long)c.disconnects,
+         (unsigned long long)c.otaRequests,
+         rain.percentileMs(0.50), rain.percentileMs(0.99), rain.maxMs(),
+         (unsigned long long)c.rainEvents);
+  fflush(stdout);
+
+  if (!final) {
+    window = Counters();
+    commandRtt.clear();
+    connectLatency.clear();
+    rainLatency.clear();
+  }
+}
+
+// ===== Dòng lệnh =====
+void usage(const char* program) {
+  printf("Usage: %s [options]\n"
+         "  --host H            Broker host (127.0.0.1)\n"
+         "  --port P            Broker port (1883)\n"
+         "  --devices N         Số thiết bị ảo (100)\n"
+         "  --prefix S          Tiền tố deviceId (SIM_)\n"
+         "  --ramp N            Thiết bị khởi động mỗi giây (200)\n"
+         "  --duration S        Thời gian chạy, giây (60)\n"
+         "  --loop-ms MS        Chu kỳ loop() (100)\n"
+         "  --heartbeat-ms MS   Chu kỳ điều khiển + heartbeat (mặc định firmware)\n"
+         "  --sensor-ms MS      Chu kỳ gửi sensor data (mặc định firmware)\n"
+         "  --drop-rate P       Xác suất rớt kết nối mỗi thiết bị mỗi giây (0)\n"
+         "  --storm-every S     Ngắt đồng loạt mọi kết nối mỗi S giây (0 = tắt)\n"
+         "  --wifi-outage-ms MS Mất WiFi sau mỗi storm (0)\n"
+         "  --cmd-rate N        Lệnh relay2 mỗi giây từ monitor (1)\n"
+         "  --ota-every S       Gửi firmware/update mỗi S giây (0 = tắt)\n"
+         "  --rain-per-min N    Số lần mưa/tạnh mỗi thiết bị mỗi phút (0.2)\n"
+         "  --report S          Chu kỳ báo cáo, giây (5)\n"
+         "  --verbose           In Serial log của firmware\n",
+         program);
+}
+
+bool parseOptions(int argc, char** argv) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    auto next = [&]() -> const char* { return i + 1 < argc ? argv[++i] : ""; };
+    if (arg == "--host") options.host = next();
+    else if (arg == "--port") options.port = atoi(next());
+    else if (arg == "--devices") options.devices = atoi(next());
+    else if (arg == "--prefix") options.idPrefix = next();
+    else if (arg == "--ramp") options.rampPerSec = atoi(next());
+    else if (arg == "--duration") options.durationSec = atoi(next());
+    else if (arg == "--loop-ms") options.loopMs = atoi(next());
+    else if (arg == "--heartbeat-ms") options.heartbeatMs = atoi(next());
+    else if (arg == "--sensor-ms") options.sensorMs = atoi(next());
+    else if (arg == "--drop-rate") options.dropRate = atof(next());
+    else if (arg == "--storm-every") options.stormEverySec = atoi(next());
+    else if (arg == "--wifi-outage-ms") options.wifiOutageMs = atoi(next());
+    else if (arg == "--cmd-rate") options.commandRate = atof(next());
+    else if (arg == "--ota-every") options.otaEverySec = atoi(next());
+    else if (arg == "--rain-per-min") options.rainPerMinute = atof(next());
+    else if (arg == "--report") options.reportSec = atoi(next());
+    else if (arg == "--verbose") options.verbose = true;
+    else {
+      usage(argv[0]);
+      return false;
+    }
+  }
+  return options.devices > 0 && options.rampPerSec > 0 && options.loopMs > 0 && options.reportSec > 0;
+}
+
+bool resolveBroker() {
+  addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* result = nullptr;
+  if (getaddrinfo(options.host.c_str(), nullptr, &hints, &result) != 0 || !result) {
+    return false;
+  }
+  brokerAddress = *(sockaddr_in*)result->ai_addr;
+  brokerAddress.sin_port = htons(options.port);
+  freeaddrinfo(result);
+  return true;
+}
+
+void raiseFileLimit() {
+  rlimit limit;
+  if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+  }
+  getrlimit(RLIMIT_NOFILE, &limit);
+  if ((rlim_t)options.devices + 64 > limit.rlim_cur) {
+    fprintf(stderr, "⚠️  RLIMIT_NOFILE=%llu is too low for %d devices (ulimit -n)\n",
+            (unsigned long long)limit.rlim_cur, options.devices);
+  }
+}
+
+}  // namespace
+
+// ===== SimHooks (gọi từ shim/) =====
+SimHardware* simHardware() {
+  return current ? &current->hw : &idleHardware;
+}
+
+bool simMqttConnect(const char* clientId, uint16_t keepAlive) {
+  VirtualDevice& dev = *current;
+  count(&Counters::connectAttempts);
+  dev.connectStartUs = nowUs();
+  if (!dev.mqtt.open(brokerAddress, clientId, keepAlive)) {
+    count(&Counters::connectFailures);
+    return false;
+  }
+  return true;
+}
+
+bool simMqttConnected() {
+  return current && current->mqtt.state() != MqttConnection::CLOSED;
+}
+
+bool simMqttSubscribe(const char* topic) {
+  if (!current || current->mqtt.fd() < 0) return false;
+  current->mqtt.queueSubscribe(topic);
+  return true;
+}
+
+bool simMqttPublish(const char* topic, const uint8_t* payload, size_t length) {
+  if (!current || current->mqtt.fd() < 0) return false;
+  current->mqtt.queuePublish(topic, std::string((const char*)payload, length));
+  count(&Counters::devicePublishes);
+  count(&Counters::deviceBytes, strlen(topic) + length);
+  return true;
+}
+
+void simMqttDisconnect() {
+  if (current && current->mqtt.fd() >= 0) {
+    current->mqtt.queueDisconnect();
+    current->mqtt.flush();
+    current->mqtt.close();
+  }
+}
+
+int simMqttState() {
+  if (!current) return -1;
+  if (current->mqtt.state() != MqttConnection::CLOSED) return 0;
+  int code = current->mqtt.connackCode();
+  return code > 0 ? code : -1;
+}
+
+void simLog(const std::string& line) {
+  if (options.verbose) {
+    printf("[%s] %s\n", current ? current->id.c_str() : "-", line.c_str());
+  }
+}
+
+void simOtaRequested(const char*) {
+  count(&Counters::otaRequests);
+}
+
+int main(int argc, char** argv) {
+  if (!parseOptions(argc, argv)) {
+    return 1;
+  }
+  if (!resolveBroker()) {
+    fprintf(stderr, "❌ Cannot resolve broker %s\n", options.host.c_str());
+    return 1;
+  }
+  signal(SIGPIPE, SIG_IGN);
+  signal(SIGINT, [](int) { stopRequested = 1; });
+  raiseFileLimit();
+  srand(getpid());
+
+  epollFd = epoll_create1(EPOLL_CLOEXEC);
+  if (epollFd < 0) {
+    perror("epoll_create1");
+    return 1;
+  }
+
+  printf("🚀 Fleet simulator: %d devices -> %s:%d (ramp %d/s, %d s)\n", options.devices,
+         options.host.c_str(), options.port, options.rampPerSec, options.durationSec);
+
+  for (int i = 0; i < options.devices; i++) {
+    char id[64];
+    snprintf(id, sizeof(id), "%s%05d", options.idPrefix.c_str(), i);
+    auto dev = std::unique_ptr<VirtualDevice>(new VirtualDevice());
+    dev->id = id;
+    dev->fw = fwCreate(id);
+    deviceIndex[id] = i;
+    fleet.push_back(std::move(dev));
+  }
+
+  monitorConnect();
+
+  // Hàng đợi loop(): (thời điểm chạy, chỉ số thiết bị)
+  typedef std::pair<unsigned long, int> Due;
+  std::priority_queue<Due, std::vector<Due>, std::greater<Due>> schedule;
+
+  const unsigned long start = millis();
+  const unsigned long end = start + options.durationSec * 1000UL;
+  unsigned long lastHousekeeping = start;
+  unsigned long lastReport = start;
+  unsigned long lastStorm = start;
+  unsigned long lastOta = start;
+  unsigned long lastMonitorPing = start;
+  double commandCredit = 0;
+  int nextToStart = 0;
+
+  std::string intervals;
+  if (options.heartbeatMs > 0 || options.sensorMs > 0) {
+    intervals = "{\"intervals\":{";
+    if (options.heartbeatMs > 0) intervals += "\"loop\":" + std::to_string(options.heartbeatMs);
+    if (options.heartbeatMs > 0 && options.sensorMs > 0) intervals += ",";
+    if (options.sensorMs > 0) intervals += "\"sensorPublish\":" + std::to_string(options.sensorMs);
+    intervals += "}}";
+  }
+
+  const double rainProbability = options.rainPerMinute / 60.0 * options.loopMs / 1000.0;
+
+  std::vector<epoll_event> events(1024);
+  while (!stopRequested) {
+    unsigned long now = millis();
+    if (now >= end) break;
+
+    // Khởi động thiết bị theo ramp
+    int shouldStart = std::min<long>(options.devices, (long)(now - start) * options.rampPerSec / 1000 + 1);
+    while (nextToStart < shouldStart) {
+      int index = nextToStart++;
+      VirtualDevice& dev = *fleet[index];
+      dev.started = true;
+      runFirmware(index, [&] {
+        fwSimulateEnvironment(dev.hw, 0);
+        if (!intervals.empty()) {
+          fwConfigure(intervals);  // Ghi NVS trước setup() giống thiết bị đã nhận config
+        }
+        fwSetup();
+      });
+      schedule.push(Due(now + options.loopMs, index));
+    }
+
+    // Chạy loop() của các thiết bị đến hạn
+    while (!schedule.empty() && schedule.top().first <= now) {
+      int index = schedule.top().second;
+      schedule.pop();
+      VirtualDevice& dev = *fleet[index];
+      runFirmware(index, [&] {
+        unsigned long latencyUs = 0;
+        unsigned long before = fwRainEvents(latencyUs);
+        fwSimulateEnvironment(dev.hw, rainProbability);
+        fwLoop();
+        if (fwRainEvents(latencyUs) != before) {
+          count(&Counters::rainEvents);
+          rainLatency.add(latencyUs);
+          rainLatencyTotal.add(latencyUs);
+        }
+      });
+      schedule.push(Due(now + options.loopMs, index));
+    }
+
+    // Housekeeping mỗi 100 ms: lỗi giả lập, lệnh, báo cáo
+    if (now - lastHousekeeping >= 100) {
+      double elapsed = (now - lastHousekeeping) / 1000.0;
+      lastHousekeeping = now;
+      uint64_t us = nowUs();
+
+      for (auto& dev : fleet) {
+        if (!dev->started) continue;
+        if (!dev->hw.wifiUp && dev->wifiBackAt <= now) {
+          dev->hw.wifiUp = true;
+        }
+        if (options.dropRate > 0 && dev->mqtt.state() == MqttConnection::CONNECTED &&
+            rand() < options.dropRate * elapsed * RAND_MAX) {
+          dropDevice(*dev);
+        }
+        if (dev->commandPending && us - dev->commandSentUs > COMMAND_TIMEOUT_US) {
+          dev->commandPending = false;
+          count(&Counters::commandTimeouts);
+        }
+      }
+
+      if (options.stormEverySec > 0 && now - lastStorm >= options.stormEverySec * 1000UL) {
+        lastStorm = now;
+        reconnectStorm();
+      }
+      if (options.otaEverySec > 0 && now - lastOta >= options.otaEverySec * 1000UL) {
+        lastOta = now;
+        sendOtaCommand();
+      }
+
+      if (now - lastMonitorPing >= 30000) {
+        lastMonitorPing = now;
+        monitor.queuePing();
+      }
+
+      commandCredit += options.commandRate * elapsed;
+      while (commandCredit >= 1) {
+        commandCredit -= 1;
+        sendCommand();
+      }
+      monitorSync();
+
+      if (now - lastReport >= options.reportSec * 1000UL) {
+        report((now - start) / 1000.0, (now - lastReport) / 1000.0, false);
+        lastReport = now;
+      }
+    }
+
+    // Chờ I/O tới lần loop() kế tiếp
+    int timeout = 100;
+    if (!schedule.empty()) {
+      timeout = (int)std::min<long>(timeout, std::max<long>(0, (long)schedule.top().first - (long)millis()));
+    }
+    int n = epoll_wait(epollFd, events.data(), events.size(), timeout);
+    for (int i = 0; i < n; i++) {
+      uint64_t tag = events[i].data.u64;
+      if (tag == MONITOR_TAG) {
+        handleMonitorIo(events[i].events);
+      } else {
+        handleDeviceIo((int)tag, events[i].events);
+      }
+    }
+  }
+
+  report((millis() - start) / 1000.0, 0, true);
+
+  for (auto& dev : fleet) {
+    fwDestroy(dev->fw);
+  }
+  return 0;
+}
@@ -0,0 +1,224 @@
+/**
+ * MQTT 3.1.1 Connection - cài đặt
+ */
+
+#include "MqttConnection.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+const uint8_t MQTT_CONNECT = 0x10;
+const uint8_t MQTT_CONNACK = 0x20;
+const uint8_t MQTT_PUBLISH = 0x30;
+const uint8_t MQTT_SUBSCRIBE = 0x82;  // Flags bắt buộc 0010
+const uint8_t MQTT_SUBACK = 0x90;
+const uint8_t MQTT_PINGREQ = 0xC0;
+const uint8_t MQTT_PINGRESP = 0xD0;
+const uint8_t MQTT_DISCONNECT = 0xE0;
+
+void appendUint16(std::string& buffer, uint16_t value) {
+  buffer += (char)(value >> 8);
+  buffer += (char)(value & 0xFF);
+}
+
+void appendString(std::string& buffer, const std::string& text) {
+  appendUint16(buffer, text.size());
+  buffer += text;
+}
+
+}  // namespace
+
+bool MqttConnection::open(const sockaddr_in& broker, const std::string& clientId, uint16_t keepAlive) {
+  close();
+
+  socketFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (socketFd < 0) {
+    return false;
+  }
+  int one = 1;
+  setsockopt(socketFd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+  if (connect(socketFd, (const sockaddr*)&broker, sizeof(broker)) < 0 && errno != EINPROGRESS) {
+    ::close(socketFd);
+    socketFd = -1;
+    return false;
+  }
+
+  currentState = CONNECTING;
+  lastConnack = -1;
+
+  std::string body;
+  appendString(body, "MQTT");
+  body += (char)4;     // Protocol level 3.1.1
+  body += (char)0x02;  // Clean session
+  appendUint16(body, keepAlive);
+  appendString(body, clientId);
+  queuePacket(MQTT_CONNECT, body);
+  return true;
+}
+
+void MqttConnection::close() {
+  if (socketFd >= 0) {
+    ::close(socketFd);
+  }
+  socketFd = -1;
+  currentState = CLOSED;
+  out.clear();
+  outOffset = 0;
+  in.clear();
+}
+
+void MqttConnection::queuePacket(uint8_t header, const std::string& body) {
+  out += (char)header;
+  size_t length = body.size();
+  do {
+    uint8_t digit = length % 128;
+    length /= 128;
+    if (length > 0) digit |= 0x80;
+    out += (char)digit;
+  } while (length > 0);
+  out += body;
+  packetsSent++;
+}
+
+void MqttConnection::queueSubscribe(const std::string& topic) {
+  std::string body;
+  appendUint16(body, nextPacketId++);
+  if (nextPacketId == 0) nextPacketId = 1;
+  appendString(body, topic);
+  body += (char)0;  // QoS 0
+  queuePacket(MQTT_SUBSCRIBE, body);
+}
+
+void MqttConnection::queuePublish(const std::string& topic, const std::string& payload) {
+  std::string body;
+  appendString(body, topic);
+  body += payload;
+  queuePacket(MQTT_PUBLISH, body);
+}
+
+void MqttConnection::queuePing() {
+  queuePacket(MQTT_PINGREQ, std::string());
+}
+
+void MqttConnection::queueDisconnect() {
+  queuePacket(MQTT_DISCONNECT, std::string());
+}
+
+bool MqttConnection::flush() {
+  if (socketFd < 0) {
+    return false;
+  }
+  while (outOffset < out.size()) {
+    ssize_t n = send(socketFd, out.data() + outOffset, out.size() - outOffset, MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR || errno == ENOTCONN) {
+        break;  // ENOTCONN: TCP chưa kết nối xong, đợi EPOLLOUT
+      }
+      return false;
+    }
+    outOffset += n;
+    bytesSent += n;
+  }
+  if (outOffset == out.size()) {
+    out.clear();
+    outOffset = 0;
+  } else if (outOffset > 64 * 1024) {
+    out.erase(0, outOffset);
+    outOffset = 0;
+  }
+  return true;
+}
+
+bool MqttConnection::receive(const PublishHandler& onPublish) {
+  if (socketFd < 0) {
+    return false;
+  }
+
+  char buffer[4096];
+  for (;;) {
+    ssize_t n = recv(socketFd, buffer, sizeof(buffer), 0);
+    if (n > 0) {
+      in.append(buffer, n);
+      bytesReceived += n;
+      continue;
+    }
+    if (n == 0) {
+      return false;  // Broker đóng kết nối
+    }
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      break;
+    }
+    if (errno != EINTR) {
+      return false;
+    }
+  }
+
+  size_t offset = 0;
+  while (in.size() - offset >= 2) {
+    size_t length = 0;
+    size_t multiplier = 1;
+    size_t pos = offset + 1;
+    bool complete = false;
+    while (pos < in.size() && pos - offset <= 4) {
+      uint8_t digit = in[pos++];
+      length += (digit & 0x7F) * multiplier;
+      multiplier *= 128;
+      if (!(digit & 0x80)) {
+        complete = true;
+        break;
+      }
+    }
+    if (!complete) {
+      if (pos - offset > 4) return false;  // Remaining length sai định dạng
+      break;
+    }
+    if (in.size() - pos < length) {
+      break;
+    }
+    uint8_t header = in[offset];
+    std::string body = in.substr(pos, length);
+    offset = pos + length;
+    packetsReceived++;
+    if (!handlePacket(header, body, onPublish)) {
+      return false;
+    }
+  }
+  in.erase(0, offset);
+  return true;
+}
+
+bool MqttConnection::handlePacket(uint8_t header, const std::string& body, const PublishHandler& onPublish) {
+  switch (header & 0xF0) {
+    case MQTT_CONNACK:
+      if (body.size() < 2) return false;
+      lastConnack = (uint8_t)body[1];
+      if (lastConnack != 0) return false;
+      currentState = CONNECTED;
+      return true;
+
+    case MQTT_PUBLISH: {
+      if (body.size() < 2) return false;
+      size_t topicLength = ((uint8_t)body[0] << 8) | (uint8_t)body[1];
+      size_t payloadStart = 2 + topicLength;
+      if ((header & 0x06) != 0) payloadStart += 2;  // QoS > 0: packet id
+      if (payloadStart > body.size()) return false;
+      if (onPublish) {
+        onPublish(body.substr(2, topicLength), body.substr(payloadStart));
+      }
+      return true;
+    }
+
+    case MQTT_SUBACK:
+    case MQTT_PINGRESP:
+      return true;
+
+    default:
+      return true;
+  }
+}
@@ -0,0 +1,71 @@
+/**
+ * MQTT 3.1.1 Connection (non-blocking, QoS 0)
+ * Mã hóa/giải mã gói MQTT trên socket TCP non-blocking để chạy hàng nghìn
+ * kết nối trong một event loop epoll.
+ */
+
+#ifndef MQTT_CONNECTION_H
+#define MQTT_CONNECTION_H
+
+#include <netinet/in.h>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+class MqttConnection {
+ public:
+  enum State { CLOSED, CONNECTING, CONNECTED };
+
+  // Gói PUBLISH nhận được (topic, payload)
+  typedef std::function<void(const std::string&, const std::string&)> PublishHandler;
+
+  ~MqttConnection() { close(); }
+
+  /**
+   * Mở socket non-blocking và xếp hàng gói CONNECT
+   * @return false nếu không tạo được socket
+   */
+  bool open(const sockaddr_in& broker, const std::string& clientId, uint16_t keepAlive);
+  void close();
+
+  void queueSubscribe(const std::string& topic);
+  void queuePublish(const std::string& topic, const std::string& payload);
+  void queuePing();
+  void queueDisconnect();
+
+  /**
+   * Ghi dữ liệu đang chờ ra socket
+   * @return false nếu socket lỗi
+   */
+  bool flush();
+
+  /**
+   * Đọc hết dữ liệu sẵn có và xử lý các gói hoàn chỉnh
+   * @return false nếu socket đóng/lỗi hoặc broker từ chối CONNECT
+   */
+  bool receive(const PublishHandler& onPublish);
+
+  int fd() const { return socketFd; }
+  State state() const { return currentState; }
+  bool hasPendingOutput() const { return outOffset < out.size(); }
+  int connackCode() const { return lastConnack; }
+
+  uint64_t packetsSent = 0;
+  uint64_t packetsReceived = 0;
+  uint64_t bytesSent = 0;
+  uint64_t bytesReceived = 0;
+
+ private:
+  int socketFd = -1;
+  State currentState = CLOSED;
+  int lastConnack = -1;
+  uint16_t nextPacketId = 1;
+  std::string out;
+  size_t outOffset = 0;
+  std::string in;
+
+  void queuePacket(uint8_t header, const std::string& body);
+  bool handlePacket(uint8_t header, const std::string& body, const PublishHandler& onPublish);
+};
+
+#endif
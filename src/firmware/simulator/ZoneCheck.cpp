@@ -0,0 +1,191 @@
+/**
+ * Zone Check
+ * Kiểm tra điều khiển nhiều vùng tưới trên host, không cần broker: chạy firmware
+ * (Firmware.cpp) với board nhiều vùng, thay kết nối MQTT bằng bộ ghi trong bộ nhớ.
+ *  - Subscribe command/config/firmware riêng (không wildcard nhận lại message của chính mình)
+ *  - Lệnh theo vùng (action đơn lẻ và batch), vùng sai bị từ chối
+ *  - Mode/ngưỡng riêng từng vùng, logic tự động theo cảm biến đất của từng vùng
+ *  - Telemetry tất cả vùng trong một message sensor/data
+ *
+ * Build với board nhiều vùng, xem README.md. Thoát 0 nếu mọi kiểm tra đạt.
+ */
+
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Arduino.h"
+#include "Firmware.h"
+#include <BoardProfiles.h>
+
+static_assert(Board::ZONE_COUNT >= 3, "Build with -DBOARD_PROFILE=irrigation_zones_v1");
+
+namespace {
+
+const char* DEVICE_ID = "ZONE_001";
+const std::string TOPIC_BASE = std::string("iot/device/") + DEVICE_ID;
+
+SimHardware hardware;
+std::vector<std::string> subscriptions;
+std::vector<std::pair<std::string, std::string>> published;
+bool mqttUp = false;
+bool verbose = false;
+int failures = 0;
+
+void check(bool ok, const char* what) {
+  printf("%s %s\n", ok ? "PASS" : "FAIL", what);
+  if (!ok) {
+    failures++;
+  }
+}
+
+// Relay kích mức LOW (actuatorDef().activeLow)
+bool zonePumpOn(int zone) {
+  return hardware.pins[Board::ZONE_RELAY_PINS[zone]] == LOW;
+}
+
+bool pumps(bool z0, bool z1, bool z2) {
+  return zonePumpOn(0) == z0 && zonePumpOn(1) == z1 && zonePumpOn(2) == z2;
+}
+
+size_t countPublished(const std::string& topic) {
+  size_t n = 0;
+  for (const auto& message : published) {
+    if (message.first == topic) {
+      n++;
+    }
+  }
+  return n;
+}
+
+size_t countOccurrences(const std::string& text, const std::string& needle) {
+  size_t n = 0;
+  for (size_t pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + 1)) {
+    n++;
+  }
+  return n;
+}
+
+void deliver(const char* suffix, const std::string& payload) {
+  fwDeliver(TOPIC_BASE + suffix, payload);
+}
+
+}  // namespace
+
+// ===== SimHooks (gọi từ shim/) =====
+SimHardware* simHardware() {
+  return &hardware;
+}
+
+bool simMqttConnect(const char*, uint16_t) {
+  mqttUp = true;
+  return true;
+}
+
+bool simMqttConnected() {
+  return mqttUp;
+}
+
+bool simMqttSubscribe(const char* topic) {
+  subscriptions.push_back(topic);
+  return true;
+}
+
+bool simMqttPublish(const char* topic, const uint8_t* payload, size_t length) {
+  published.emplace_back(topic, std::string((const char*)payload, length));
+  return true;
+}
+
+void simMqttDisconnect() {
+  mqttUp = false;
+}
+
+int simMqttState() {
+  return mqttUp ? 0 : -1;
+}
+
+void simLog(const std::string& line) {
+  if (verbose) {
+    printf("  | %s\n", line.c_str());
+  }
+}
+
+void simOtaRequested(const char*) {}
+
+int main(int argc, char** argv) {
+  verbose = argc > 1 && std::string(argv[1]) == "--verbose";
+
+  // Vùng 0 và 2 đất khô (ADC = không khí), vùng 1 đất ướt
+  hardware.analog[Board::ZONE_SOIL_PINS[0]] = Board::SOIL_AIR_VALUE;
+  hardware.analog[Board::ZONE_SOIL_PINS[1]] = Board::SOIL_WATER_VALUE;
+  hardware.analog[Board::ZONE_SOIL_PINS[2]] = Board::SOIL_AIR_VALUE;
+  hardware.pins[Board::PIN_RAIN] = HIGH;
+
+  FirmwareContext* device = fwCreate(DEVICE_ID);
+  fwEnter(device);
+  fwSetup();
+
+  check(subscriptions.size() == 3 && subscriptions[0] == TOPIC_BASE + "/command" &&
+        subscriptions[1] == TOPIC_BASE + "/config" &&
+        subscriptions[2] == TOPIC_BASE + "/firmware/update",
+        "command/config/firmware subscriptions, no wildcard");
+  check(pumps(true, false, true), "auto control per zone soil sensor at boot");
+
+  // Mode/ngưỡng theo vùng
+  deliver("/config", "{\"zone\":1,\"mode\":\"manual\"}");
+  deliver("/config", "{\"zones\":[{\"zone\":2,\"mode\":\"off\"},"
+                     "{\"zone\":0,\"threshold\":{\"soilDry\":0,\"soilWet\":1}}]}");
+  deliver("/config", "{\"zone\":7,\"mode\":\"off\"}");
+  fwExpireTimers();
+  fwLoop();
+  check(pumps(true, false, false), "zone 2 off by mode, zone 0 untouched by auto (0% between thresholds)");
+
+  // Vùng ướt bật thủ công, không bị logic tự động tắt vì vùng 1 đang manual
+  deliver("/command", "{\"zone\":1,\"action\":\"pump_on\"}");
+  fwExpireTimers();
+  fwLoop();
+  check(pumps(true, true, false), "zone-addressed action, manual zone kept on");
+
+  deliver("/command", "{\"actions\":[{\"zone\":0,\"state\":\"off\"},{\"zone\":1,\"state\":false}]}");
+  check(pumps(false, false, false), "zone-addressed batch");
+
+  deliver("/command", "{\"actions\":[{\"zone\":1,\"state\":\"on\"},{\"zone\":3,\"state\":\"on\"}]}");
+  deliver("/command", "{\"zone\":5,\"action\":\"pump_on\"}");
+  deliver("/command", "{\"zone\":2,\"action\":\"relay2_on\"}");
+  check(pumps(false, false, false), "invalid zone rejected (batch all-or-nothing)");
+
+  // Telemetry: một message cho tất cả vùng mỗi chu kỳ
+  published.clear();
+  fwExpireTimers();
+  fwLoop();
+  const std::string sensorTopic = TOPIC_BASE + "/sensor/data";
+  check(countPublished(sensorTopic) == 1, "one sensor/data message per interval");
+  std::string payload;
+  for (const auto& message : published) {
+    if (message.first == sensorTopic) {
+      payload = message.second;
+    }
+  }
+  check(countOccurrences(payload, "\"zone\":") == 3 &&
+        payload.find("\"mode\":\"manual\"") != std::string::npos &&
+        payload.find("\"mode\":\"off\"") != std::string::npos,
+        "sensor/data carries all zones with their modes");
+  if (verbose) {
+    printf("  sensor/data: %s\n", payload.c_str());
+  }
+
+  // Config theo vùng được lưu NVS (v2) và nạp lại sau reboot
+  fwLeave(device);
+  fwDestroy(device);
+  device = fwCreate(DEVICE_ID);
+  fwEnter(device);
+  subscriptions.clear();
+  fwSetup();
+  check(pumps(false, false, false), "per-zone config restored from NVS after reboot");
+  fwLeave(device);
+  fwDestroy(device);
+
+  printf("%s (%d failed)\n", failures == 0 ? "ALL PASSED" : "FAILED", failures);
+  return failures == 0 ? 0 : 1;
+}
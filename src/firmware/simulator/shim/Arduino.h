@@ -0,0 +1,172 @@
+/**
+ * Arduino core shim cho Linux (chỉ đủ cho firmware trong main/)
+ */
+
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "SimHooks.h"
+
+using std::isnan;
+using std::max;
+using std::min;
+
+typedef uint8_t byte;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define RISING 1
+#define FALLING 2
+#define CHANGE 3
+#define HEX 16
+#define DEC 10
+#define IRAM_ATTR
+
+class String {
+ public:
+  String() {}
+  String(const char* text) : value(text ? text : "") {}
+  String(const std::string& text) : value(text) {}
+  String(char c) : value(1, c) {}
+  String(int number, int base = DEC) : value(format(base == HEX ? "%x" : "%d", number)) {}
+  String(unsigned int number, int base = DEC) : value(format(base == HEX ? "%x" : "%u", number)) {}
+  String(long number, int base = DEC) : value(format(base == HEX ? "%lx" : "%ld", number)) {}
+  String(unsigned long number, int base = DEC) : value(format(base == HEX ? "%lx" : "%lu", number)) {}
+  String(double number, int decimals = 2) {
+    char buffer[48];
+    snprintf(buffer, sizeof(buffer), "%.*f", decimals, number);
+    value = buffer;
+  }
+
+  const char* c_str() const { return value.c_str(); }
+  unsigned int length() const { return value.size(); }
+  bool reserve(unsigned int size) { value.reserve(size); return true; }
+  long toInt() const { return atol(value.c_str()); }
+  bool startsWith(const String& prefix) const { return value.compare(0, prefix.value.size(), prefix.value) == 0; }
+  String substring(unsigned int from) const { return from < value.size() ? value.substr(from) : std::string(); }
+  String substring(unsigned int from, unsigned int to) const {
+    return from < value.size() && to > from ? value.substr(from, to - from) : std::string();
+  }
+  int indexOf(char c, unsigned int from = 0) const { return position(value.find(c, from)); }
+  int indexOf(const String& text, unsigned int from = 0) const { return position(value.find(text.value, from)); }
+  int lastIndexOf(char c) const { return position(value.rfind(c)); }
+  char operator[](unsigned int index) const { return index < value.size() ? value[index] : 0; }
+
+  String& operator+=(const String& other) { value += other.value; return *this; }
+  String& operator+=(const char* other) { value += other; return *this; }
+  String& operator+=(char c) { value += c; return *this; }
+  bool operator==(const String& other) const { return value == other.value; }
+  bool operator==(const char* other) const { return value == other; }
+  bool operator!=(const String& other) const { return value != other.value; }
+  bool operator!=(const char* other) const { return value != other; }
+  friend String operator+(const String& a, const String& b) { return String(a.value + b.value); }
+  friend String operator+(const String& a, const char* b) { return String(a.value + b); }
+  friend String operator+(const char* a, const String& b) { return String(a + b.value); }
+
+  const std::string& str() const { return value; }
+
+ private:
+  std::string value;
+
+  static int position(size_t pos) { return pos == std::string::npos ? -1 : (int)pos; }
+  template <class T>
+  static std::string format(const char* fmt, T number) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), fmt, number);
+    return buffer;
+  }
+};
+
+// Serial: gom theo dòng rồi chuyển cho simLog (simulator quyết định in hay bỏ)
+class HardwareSerial {
+ public:
+  void begin(unsigned long) {}
+  void print(const String& text) { line += text.str(); }
+  void print(const char* text) { line += text; }
+  void print(char c) { line += c; }
+  void print(int number, int base = DEC) { line += String(number, base).str(); }
+  void print(unsigned int number, int base = DEC) { line += String(number, base).str(); }
+  void print(long number, int base = DEC) { line += String(number, base).str(); }
+  void print(unsigned long number, int base = DEC) { line += String(number, base).str(); }
+  void print(double number) { line += String(number).str(); }
+  template <class T>
+  void println(const T& value) { print(value); println(); }
+  void println() { simLog(line); line.clear(); }
+  // Không có dữ liệu vào: thiết bị ảo được provisioning trực tiếp qua NVS
+  int available() { return 0; }
+  int read() { return -1; }
+
+ private:
+  std::string line;
+};
+
+extern HardwareSerial Serial;
+
+// ===== ESP (Esp.h) =====
+class EspClass {
+ public:
+  void restart() {}
+  uint32_t getFreeHeap() { return 0; }
+  uint64_t getEfuseMac() { return 0; }
+};
+
+extern EspClass ESP;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+inline void yield() {}
+inline long random(long limit) { return limit > 0 ? rand() % limit : 0; }
+inline long random(long low, long high) { return high > low ? low + rand() % (high - low) : low; }
+
+void pinMode(int pin, int mode);
+void digitalWrite(int pin, int level);
+int digitalRead(int pin);
+int analogRead(int pin);
+
+// ===== Ngắt GPIO =====
+inline int digitalPinToInterrupt(int pin) { return pin; }
+void attachInterrupt(int pin, void (*handler)(), int mode);
+void detachInterrupt(int pin);
+
+// ===== FreeRTOS queue =====
+// Simulator không có scheduler: xQueueReceive() không chặn, event loop tự gọi
+// loop() ngay khi ISR đẩy sự kiện (tương đương task được đánh thức).
+typedef int BaseType_t;
+typedef uint32_t TickType_t;
+typedef struct SimQueue* QueueHandle_t;  // Chỉ số queue + 1, không phải con trỏ thật
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdMS_TO_TICKS(ms) (ms)
+#define portYIELD_FROM_ISR(...)
+
+// Không có task song song: critical section là no-op
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+
+QueueHandle_t xQueueCreate(unsigned int length, unsigned int itemSize);
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void* item, BaseType_t* woken);
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks);
+
+inline long map(long x, long inMin, long inMax, long outMin, long outMax) {
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+template <class T, class L, class H>
+T constrain(T x, L low, H high) {
+  return x < low ? low : (x > high ? high : x);
+}
+
+#endif
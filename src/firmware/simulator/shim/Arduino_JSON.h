@@ -0,0 +1,97 @@
+/**
+ * Arduino_JSON shim: JSONVar + JSON.parse/stringify/typeof với đủ API firmware dùng
+ */
+
+#ifndef SIM_ARDUINO_JSON_H
+#define SIM_ARDUINO_JSON_H
+
+#include <utility>
+#include <vector>
+#include "Arduino.h"
+
+class JSONVar {
+ public:
+  enum Type { UNDEFINED, NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+
+  JSONVar() {}
+  JSONVar(bool value) : type(BOOLEAN), boolean(value) {}
+  JSONVar(int value) : type(NUMBER), number(value) {}
+  JSONVar(long value) : type(NUMBER), number(value) {}
+  JSONVar(unsigned long value) : type(NUMBER), number(value) {}
+  JSONVar(double value) : type(NUMBER), number(value) {}
+  JSONVar(const char* value) : type(value ? STRING : NUL), text(value ? value : "") {}
+  JSONVar(const String& value) : type(STRING), text(value.str()) {}
+
+  operator bool() const { return type == BOOLEAN ? boolean : number != 0; }
+  operator int() const { return (int)number; }
+  operator long() const { return (long)number; }
+  operator double() const { return number; }
+  operator const char*() const { return type == STRING ? text.c_str() : nullptr; }
+
+  bool hasOwnProperty(const char* key) const { return find(key) != nullptr; }
+  int length() const { return type == ARRAY ? (int)items.size() : type == OBJECT ? (int)members.size() : -1; }
+
+  JSONVar& operator[](const char* key) {
+    if (type != OBJECT) {
+      *this = JSONVar();
+      type = OBJECT;
+    }
+    if (JSONVar* found = const_cast<JSONVar*>(find(key))) {
+      return *found;
+    }
+    members.emplace_back(key, JSONVar());
+    return members.back().second;
+  }
+  JSONVar operator[](const char* key) const {
+    const JSONVar* found = find(key);
+    return found ? *found : JSONVar();
+  }
+  JSONVar& operator[](int index) {
+    if (type != ARRAY) {
+      *this = JSONVar();
+      type = ARRAY;
+    }
+    if (index >= (int)items.size()) {
+      items.resize(index + 1);
+    }
+    return items[index];
+  }
+
+ private:
+  friend class JSONClass;
+
+  Type type = UNDEFINED;
+  bool boolean = false;
+  double number = 0;
+  std::string text;
+  std::vector<JSONVar> items;
+  std::vector<std::pair<std::string, JSONVar>> members;
+
+  const JSONVar* find(const char* key) const {
+    for (const auto& member : members) {
+      if (member.first == key) {
+        return &member.second;
+      }
+    }
+    return nullptr;
+  }
+};
+
+class JSONClass {
+ public:
+  JSONVar parse(const String& input) const;
+  String stringify(const JSONVar& value) const;
+  String typeof_(const JSONVar& value) const;
+
+ private:
+  static bool parseValue(const char*& p, JSONVar& out, int depth);
+  static bool parseString(const char*& p, std::string& out);
+  static void write(const JSONVar& value, std::string& out);
+};
+
+extern JSONClass JSON;
+
+// Arduino_JSON có hàm thành viên tên "typeof" (từ khóa GNU) - ánh xạ lại
+#define typeof typeof_
+
+#endif
@@ -0,0 +1,21 @@
+/**
+ * DHT shim: nhiệt độ/độ ẩm lấy từ thiết bị ảo hiện tại
+ */
+
+#ifndef SIM_DHT_H
+#define SIM_DHT_H
+
+#include "Arduino.h"
+
+#define DHT11 11
+#define DHT22 22
+
+class DHT {
+ public:
+  DHT(int, int) {}
+  void begin() {}
+  float readTemperature() { return simHardware()->temperature; }
+  float readHumidity() { return simHardware()->humidity; }
+};
+
+#endif
@@ -0,0 +1,43 @@
+/**
+ * HTTPClient shim: OTA download không được thực hiện trong simulator.
+ * GET() ghi nhận yêu cầu (simOtaRequested) rồi trả lỗi kết nối ngay để
+ * performOTAUpdate() thoát mà không chặn event loop.
+ */
+
+#ifndef SIM_HTTPCLIENT_H
+#define SIM_HTTPCLIENT_H
+
+#include "WiFi.h"
+
+#define HTTP_CODE_OK 200
+#define HTTP_CODE_MOVED_PERMANENTLY 301
+#define HTTP_CODE_FOUND 302
+#define HTTP_CODE_TEMPORARY_REDIRECT 307
+#define HTTP_CODE_BAD_REQUEST 400
+#define HTTP_CODE_UNAUTHORIZED 401
+#define HTTP_CODE_FORBIDDEN 403
+#define HTTP_CODE_NOT_FOUND 404
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_STRICT_FOLLOW_REDIRECTS 1
+
+class HTTPClient {
+ public:
+  bool begin(const String& target) { url = target; return true; }
+  void setTimeout(int) {}
+  void setFollowRedirects(int) {}
+  int GET() {
+    simOtaRequested(url.c_str());
+    return HTTPC_ERROR_CONNECTION_REFUSED;
+  }
+  String header(const char*) { return String(); }
+  int getSize() { return -1; }
+  bool connected() { return false; }
+  WiFiClient* getStreamPtr() { return &stream; }
+  void end() {}
+
+ private:
+  String url;
+  WiFiClient stream;
+};
+
+#endif
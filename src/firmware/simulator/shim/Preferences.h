@@ -0,0 +1,82 @@
+/**
+ * Preferences (NVS) shim: lưu trong bộ nhớ, riêng cho từng thiết bị ảo
+ */
+
+#ifndef SIM_PREFERENCES_H
+#define SIM_PREFERENCES_H
+
+#include "Arduino.h"
+
+class Preferences {
+ public:
+  bool begin(const char* name, bool readOnly = false) {
+    space = name;
+    (void)readOnly;
+    return true;
+  }
+  void end() {}
+
+  size_t getBytesLength(const char* key) {
+    const std::vector<uint8_t>* entry = find(key);
+    return entry ? entry->size() : 0;
+  }
+  size_t getBytes(const char* key, void* buffer, size_t length) {
+    const std::vector<uint8_t>* entry = find(key);
+    if (!entry || entry->size() > length) {
+      return 0;
+    }
+    memcpy(buffer, entry->data(), entry->size());
+    return entry->size();
+  }
+  size_t putBytes(const char* key, const void* buffer, size_t length) {
+    const uint8_t* bytes = (const uint8_t*)buffer;
+    simHardware()->nvs[space + "/" + key].assign(bytes, bytes + length);
+    return length;
+  }
+  String getString(const char* key, const String& fallback = String()) {
+    const std::vector<uint8_t>* entry = find(key);
+    return entry ? String(std::string(entry->begin(), entry->end())) : fallback;
+  }
+  size_t getString(const char* key, char* value, size_t maxLength) {
+    const std::vector<uint8_t>* entry = find(key);
+    if (!entry || entry->size() + 1 > maxLength) {
+      return 0;
+    }
+    memcpy(value, entry->data(), entry->size());
+    value[entry->size()] = '\0';
+    return entry->size() + 1;
+  }
+  size_t putString(const char* key, const String& value) {
+    return putBytes(key, value.c_str(), value.length());
+  }
+  uint16_t getUShort(const char* key, uint16_t fallback = 0) {
+    uint16_t value = fallback;
+    const std::vector<uint8_t>* entry = find(key);
+    if (entry && entry->size() == sizeof(value)) {
+      memcpy(&value, entry->data(), sizeof(value));
+    }
+    return value;
+  }
+  size_t putUShort(const char* key, uint16_t value) { return putBytes(key, &value, sizeof(value)); }
+  bool clear() {
+    auto& nvs = simHardware()->nvs;
+    std::string prefix = space + "/";
+    for (auto it = nvs.lower_bound(prefix); it != nvs.end() && it->first.compare(0, prefix.size(), prefix) == 0;) {
+      it = nvs.erase(it);
+    }
+    return true;
+  }
+  bool isKey(const char* key) { return find(key) != nullptr; }
+  bool remove(const char* key) { return simHardware()->nvs.erase(space + "/" + key) > 0; }
+
+ private:
+  std::string space;
+
+  const std::vector<uint8_t>* find(const char* key) {
+    auto& nvs = simHardware()->nvs;
+    auto it = nvs.find(space + "/" + key);
+    return it == nvs.end() ? nullptr : &it->second;
+  }
+};
+
+#endif
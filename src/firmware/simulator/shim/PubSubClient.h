@@ -0,0 +1,50 @@
+/**
+ * PubSubClient shim: chuyển mọi lời gọi tới kết nối MQTT non-blocking
+ * của thiết bị ảo hiện tại (xem FleetSim.cpp).
+ * connect() không chặn: gói CONNECT/SUBSCRIBE/PUBLISH được xếp hàng và gửi
+ * liền sau nhau (MQTT 3.1.1 cho phép gửi trước khi nhận CONNACK).
+ */
+
+#ifndef SIM_PUBSUBCLIENT_H
+#define SIM_PUBSUBCLIENT_H
+
+#include <functional>
+#include "Arduino.h"
+#include "WiFi.h"
+
+#define MQTT_CALLBACK_SIGNATURE std::function<void(char*, uint8_t*, unsigned int)> callback
+
+class PubSubClient {
+ public:
+  explicit PubSubClient(Client&) {}
+
+  PubSubClient& setServer(const char*, uint16_t) { return *this; }  // Broker do simulator chọn
+  PubSubClient& setCallback(MQTT_CALLBACK_SIGNATURE) { this->callback = callback; return *this; }
+  bool setBufferSize(uint16_t) { return true; }
+  PubSubClient& setKeepAlive(uint16_t seconds) { keepAlive = seconds; return *this; }
+  PubSubClient& setSocketTimeout(uint16_t) { return *this; }
+
+  bool connect(const char* clientId) { return simMqttConnect(clientId, keepAlive); }
+  bool connected() { return simMqttConnected(); }
+  bool subscribe(const char* topic) { return simMqttSubscribe(topic); }
+  bool publish(const char* topic, const char* payload) {
+    return simMqttPublish(topic, (const uint8_t*)payload, strlen(payload));
+  }
+  bool publish(const char* topic, const char* payload, bool) { return publish(topic, payload); }
+  bool loop() { return simMqttConnected(); }  // Event loop của simulator tự đọc socket
+  int state() { return simMqttState(); }
+  void disconnect() { simMqttDisconnect(); }
+
+  // Simulator gọi khi có PUBLISH tới thiết bị
+  void deliver(char* topic, uint8_t* payload, unsigned int length) {
+    if (callback) {
+      callback(topic, payload, length);
+    }
+  }
+
+ private:
+  std::function<void(char*, uint8_t*, unsigned int)> callback;
+  uint16_t keepAlive = 15;
+};
+
+#endif
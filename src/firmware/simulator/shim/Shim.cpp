@@ -0,0 +1,312 @@
+/**
+ * Phần cài đặt của các shim Arduino (Serial, thời gian, GPIO, JSON)
+ */
+
+#include <time.h>
+#include "Arduino.h"
+#include "Arduino_JSON.h"
+#include "esp_timer.h"
+#include "Update.h"
+#include "WiFi.h"
+
+HardwareSerial Serial;
+JSONClass JSON;
+WiFiClass WiFi;
+UpdateClass Update;
+EspClass ESP;
+
+// ===== Thời gian (CLOCK_MONOTONIC, tính từ lúc process khởi động) =====
+static uint64_t monotonicMicros() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static const uint64_t bootMicros = monotonicMicros();
+
+unsigned long micros() { return monotonicMicros() - bootMicros; }
+unsigned long millis() { return (monotonicMicros() - bootMicros) / 1000; }
+
+// delay() không được chặn event loop: thiết bị ảo chờ bằng timer của simulator
+void delay(unsigned long) {}
+
+// ===== GPIO =====
+void pinMode(int, int) {}
+
+void digitalWrite(int pin, int level) {
+  if (pin >= 0 && pin < SIM_PIN_COUNT) {
+    simHardware()->pins[pin] = level;
+  }
+}
+
+int digitalRead(int pin) {
+  return pin >= 0 && pin < SIM_PIN_COUNT ? simHardware()->pins[pin] : LOW;
+}
+
+int analogRead(int pin) {
+  return pin >= 0 && pin < SIM_PIN_COUNT ? simHardware()->analog[pin] : 0;
+}
+
+void simSetInput(int pin, int level) {
+  SimHardware* hw = simHardware();
+  if (pin < 0 || pin >= SIM_PIN_COUNT || hw->pins[pin] == level) {
+    return;
+  }
+  hw->pins[pin] = level;
+  if (hw->interrupts[pin]) {
+    hw->interrupts[pin]();
+  }
+}
+
+void attachInterrupt(int pin, void (*handler)(), int) {
+  if (pin >= 0 && pin < SIM_PIN_COUNT) {
+    simHardware()->interrupts[pin] = handler;
+  }
+}
+
+void detachInterrupt(int pin) {
+  if (pin >= 0 && pin < SIM_PIN_COUNT) {
+    simHardware()->interrupts[pin] = nullptr;
+  }
+}
+
+// ===== FreeRTOS queue (mỗi thiết bị ảo có danh sách queue riêng) =====
+// Mỗi queue lưu: [itemSize][length][dữ liệu các phần tử nối tiếp]
+QueueHandle_t xQueueCreate(unsigned int length, unsigned int itemSize) {
+  std::vector<uint8_t> queue(2);
+  queue[0] = itemSize;
+  queue[1] = length;
+  simHardware()->queues.push_back(queue);
+  return (QueueHandle_t)(uintptr_t)simHardware()->queues.size();
+}
+
+static std::vector<uint8_t>* findQueue(QueueHandle_t handle) {
+  auto& queues = simHardware()->queues;
+  uintptr_t index = (uintptr_t)handle;
+  return index == 0 || index > queues.size() ? nullptr : &queues[index - 1];
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t handle, const void* item, BaseType_t* woken) {
+  std::vector<uint8_t>* found = findQueue(handle);
+  if (!found) return pdFALSE;
+  std::vector<uint8_t>& queue = *found;
+  size_t itemSize = queue[0];
+  if ((queue.size() - 2) / itemSize >= queue[1]) return pdFALSE;  // Đầy
+  const uint8_t* bytes = (const uint8_t*)item;
+  queue.insert(queue.end(), bytes, bytes + itemSize);
+  if (woken) *woken = pdTRUE;
+  return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t handle, void* item, TickType_t) {
+  std::vector<uint8_t>* found = findQueue(handle);
+  if (!found) return pdFALSE;
+  std::vector<uint8_t>& queue = *found;
+  size_t itemSize = queue[0];
+  if (queue.size() < 2 + itemSize) return pdFALSE;
+  memcpy(item, queue.data() + 2, itemSize);
+  queue.erase(queue.begin() + 2, queue.begin() + 2 + itemSize);
+  return pdTRUE;
+}
+
+// ===== esp_timer (mỗi thiết bị ảo có danh sách timer riêng) =====
+static SimHardware::Timer* findTimer(esp_timer_handle_t handle) {
+  auto& timers = simHardware()->timers;
+  uintptr_t index = (uintptr_t)handle;
+  return index == 0 || index > timers.size() ? nullptr : &timers[index - 1];
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* out) {
+  simHardware()->timers.push_back({ args->callback, args->arg, 0, false });
+  *out = (esp_timer_handle_t)(uintptr_t)simHardware()->timers.size();
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t handle, uint64_t timeoutUs) {
+  SimHardware::Timer* timer = findTimer(handle);
+  if (!timer || timer->armed) return ESP_FAIL;  // Như ESP-IDF: phải stop trước khi start lại
+  timer->deadlineUs = micros() + timeoutUs;
+  timer->armed = true;
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t handle) {
+  SimHardware::Timer* timer = findTimer(handle);
+  if (!timer || !timer->armed) return ESP_FAIL;
+  timer->armed = false;
+  return ESP_OK;
+}
+
+int64_t esp_timer_get_time() {
+  return micros();
+}
+
+void simRunTimers() {
+  auto& timers = simHardware()->timers;
+  uint64_t now = micros();
+  for (size_t i = 0; i < timers.size(); i++) {
+    if (timers[i].armed && now >= timers[i].deadlineUs) {
+      timers[i].armed = false;
+      timers[i].callback(timers[i].arg);
+    }
+  }
+}
+
+// ===== JSON =====
+static void skipSpace(const char*& p) {
+  while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+}
+
+bool JSONClass::parseString(const char*& p, std::string& out) {
+  if (*p != '"') return false;
+  p++;
+  while (*p && *p != '"') {
+    if (*p == '\\') {
+      p++;
+      switch (*p) {
+        case 'n': out += '\n'; break;
+        case 't': out += '\t'; break;
+        case 'r': out += '\r'; break;
+        case '\0': return false;
+        default: out += *p; break;
+      }
+    } else {
+      out += *p;
+    }
+    p++;
+  }
+  if (*p != '"') return false;
+  p++;
+  return true;
+}
+
+bool JSONClass::parseValue(const char*& p, JSONVar& out, int depth) {
+  if (depth > 32) return false;
+  skipSpace(p);
+
+  if (*p == '{') {
+    p++;
+    out = JSONVar();
+    out.type = JSONVar::OBJECT;
+    skipSpace(p);
+    if (*p == '}') { p++; return true; }
+    for (;;) {
+      skipSpace(p);
+      std::string key;
+      if (!parseString(p, key)) return false;
+      skipSpace(p);
+      if (*p++ != ':') return false;
+      JSONVar child;
+      if (!parseValue(p, child, depth + 1)) return false;
+      out.members.emplace_back(key, child);
+      skipSpace(p);
+      if (*p == ',') { p++; continue; }
+      if (*p == '}') { p++; return true; }
+      return false;
+    }
+  }
+
+  if (*p == '[') {
+    p++;
+    out = JSONVar();
+    out.type = JSONVar::ARRAY;
+    skipSpace(p);
+    if (*p == ']') { p++; return true; }
+    for (;;) {
+      JSONVar child;
+      if (!parseValue(p, child, depth + 1)) return false;
+      out.items.push_back(child);
+      skipSpace(p);
+      if (*p == ',') { p++; continue; }
+      if (*p == ']') { p++; return true; }
+      return false;
+    }
+  }
+
+  if (*p == '"') {
+    std::string text;
+    if (!parseString(p, text)) return false;
+    out = JSONVar(text.c_str());
+    return true;
+  }
+  if (strncmp(p, "true", 4) == 0) { p += 4; out = JSONVar(true); return true; }
+  if (strncmp(p, "false", 5) == 0) { p += 5; out = JSONVar(false); return true; }
+  if (strncmp(p, "null", 4) == 0) { p += 4; out = JSONVar((const char*)nullptr); return true; }
+
+  char* end = nullptr;
+  double number = strtod(p, &end);
+  if (end == p) return false;
+  p = end;
+  out = JSONVar(number);
+  return true;
+}
+
+JSONVar JSONClass::parse(const String& input) const {
+  const char* p = input.c_str();
+  JSONVar value;
+  if (!parseValue(p, value, 0)) {
+    return JSONVar();
+  }
+  skipSpace(p);
+  return *p ? JSONVar() : value;
+}
+
+void JSONClass::write(const JSONVar& value, std::string& out) {
+  switch (value.type) {
+    case JSONVar::UNDEFINED:
+    case JSONVar::NUL:
+      out += "null";
+      break;
+    case JSONVar::BOOLEAN:
+      out += value.boolean ? "true" : "false";
+      break;
+    case JSONVar::NUMBER: {
+      char buffer[32];
+      if (value.number == (double)(long long)value.number) {
+        snprintf(buffer, sizeof(buffer), "%lld", (long long)value.number);
+      } else {
+        snprintf(buffer, sizeof(buffer), "%.15g", value.number);
+      }
+      out += buffer;
+      break;
+    }
+    case JSONVar::STRING:
+      out += '"';
+      for (char c : value.text) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+      }
+      out += '"';
+      break;
+    case JSONVar::ARRAY:
+      out += '[';
+      for (size_t i = 0; i < value.items.size(); i++) {
+        if (i) out += ',';
+        write(value.items[i], out);
+      }
+      out += ']';
+      break;
+    case JSONVar::OBJECT:
+      out += '{';
+      for (size_t i = 0; i < value.members.size(); i++) {
+        if (i) out += ',';
+        out += '"';
+        out += value.members[i].first;
+        out += "\":";
+        write(value.members[i].second, out);
+      }
+      out += '}';
+      break;
+  }
+}
+
+String JSONClass::stringify(const JSONVar& value) const {
+  std::string out;
+  write(value, out);
+  return String(out);
+}
+
+String JSONClass::typeof_(const JSONVar& value) const {
+  static const char* names[] = {"undefined", "null", "boolean", "number", "string", "array", "object"};
+  return String(names[value.type]);
+}
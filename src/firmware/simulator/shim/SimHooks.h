@@ -0,0 +1,55 @@
+/**
+ * Simulator Hooks
+ * Giao diện giữa các header giả lập Arduino (shim/) và fleet simulator.
+ * Firmware dùng biến toàn cục (mqttClient, pin...), nên mọi lời gọi shim
+ * được chuyển tới thiết bị ảo "hiện tại" mà simulator đã chọn trước khi gọi firmware.
+ */
+
+#ifndef SIM_HOOKS_H
+#define SIM_HOOKS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+const int SIM_PIN_COUNT = 40;
+
+// Phần cứng giả lập của một thiết bị ảo
+struct SimHardware {
+  int pins[SIM_PIN_COUNT] = {};    // Mức digital (relay, cảm biến mưa)
+  int analog[SIM_PIN_COUNT] = {};  // Giá trị ADC 12-bit
+  float temperature = 30;
+  float humidity = 60;
+  bool wifiUp = true;
+  void (*interrupts[SIM_PIN_COUNT])() = {};  // attachInterrupt(CHANGE)
+  std::vector<std::vector<uint8_t>> queues;  // Queue FreeRTOS (QueueHandle_t = chỉ số + 1)
+  struct Timer {
+    void (*callback)(void*);
+    void* arg;
+    uint64_t deadlineUs;
+    bool armed;
+  };
+  std::vector<Timer> timers;                 // esp_timer (esp_timer_handle_t = chỉ số + 1)
+  std::map<std::string, std::vector<uint8_t>> nvs;  // Preferences (namespace/key -> bytes)
+};
+
+// --- Do shim cài đặt ---
+// Đổi mức chân input của thiết bị hiện tại, gọi ISR nếu có cạnh (giống phần cứng)
+void simSetInput(int pin, int level);
+// Chạy callback esp_timer đã đến hạn của thiết bị hiện tại
+void simRunTimers();
+
+// --- Do simulator cài đặt ---
+SimHardware* simHardware();
+bool simMqttConnect(const char* clientId, uint16_t keepAlive);
+bool simMqttConnected();
+bool simMqttSubscribe(const char* topic);
+bool simMqttPublish(const char* topic, const uint8_t* payload, size_t length);
+void simMqttDisconnect();
+int simMqttState();
+void simLog(const std::string& line);
+void simOtaRequested(const char* url);
+
+#endif
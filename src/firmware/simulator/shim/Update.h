@@ -0,0 +1,22 @@
+/**
+ * Update shim: không bao giờ ghi flash
+ */
+
+#ifndef SIM_UPDATE_H
+#define SIM_UPDATE_H
+
+#include "Arduino.h"
+
+class UpdateClass {
+ public:
+  bool begin(size_t) { return false; }
+  size_t write(uint8_t*, size_t length) { return length; }
+  bool end() { return false; }
+  bool isFinished() { return false; }
+  void abort() {}
+  const char* errorString() { return "not supported in simulator"; }
+};
+
+extern UpdateClass Update;
+
+#endif
@@ -0,0 +1,42 @@
+/**
+ * WiFi shim: trạng thái WiFi lấy từ thiết bị ảo hiện tại (simHardware()->wifiUp)
+ */
+
+#ifndef SIM_WIFI_H
+#define SIM_WIFI_H
+
+#include "Arduino.h"
+
+#define WL_CONNECTED 3
+#define WL_DISCONNECTED 6
+#define WIFI_STA 1
+
+class IPAddress {
+ public:
+  operator String() const { return String("127.0.0.1"); }
+};
+
+class Client {
+ public:
+  virtual ~Client() {}
+};
+
+class WiFiClient : public Client {
+ public:
+  size_t available() { return 0; }
+  int readBytes(uint8_t*, size_t) { return 0; }
+};
+
+class WiFiClass {
+ public:
+  void mode(int) {}
+  void begin(const char*, const char*) {}
+  void setAutoReconnect(bool) {}
+  void disconnect() {}
+  int status() { return simHardware()->wifiUp ? WL_CONNECTED : WL_DISCONNECTED; }
+  IPAddress localIP() { return IPAddress(); }
+};
+
+extern WiFiClass WiFi;
+
+#endif
@@ -0,0 +1,37 @@
+/**
+ * esp_timer shim: timer một lần của thiết bị ảo hiện tại.
+ * Không có task esp_timer: simRunTimers() (gọi trước mỗi loop()) chạy các
+ * callback đã đến hạn.
+ */
+
+#ifndef SIM_ESP_TIMER_H
+#define SIM_ESP_TIMER_H
+
+#include <cstdint>
+#include "SimHooks.h"
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+
+typedef struct SimTimer* esp_timer_handle_t;  // Chỉ số timer + 1, không phải con trỏ thật
+typedef void (*esp_timer_cb_t)(void* arg);
+
+typedef enum {
+  ESP_TIMER_TASK,
+} esp_timer_dispatch_t;
+
+typedef struct {
+  esp_timer_cb_t callback;
+  void* arg;
+  esp_timer_dispatch_t dispatch_method;
+  const char* name;
+  bool skip_unhandled_events;
+} esp_timer_create_args_t;
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* out);
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeoutUs);
+esp_err_t esp_timer_stop(esp_timer_handle_t timer);
+int64_t esp_timer_get_time();
+
+#endif
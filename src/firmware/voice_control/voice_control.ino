@@ -7,7 +7,9 @@
  * - GND -> GND
  */
 
-const int MIC_PIN = 35;
+#include "Config.h"
+
+const int MIC_PIN = Board::PIN_MIC;
 
 // Chu kỳ lấy mẫu cho 16kHz: 1 giây / 16000 = 62.5 micro giây
 const unsigned long SAMPLE_PERIOD_US = 62;